@@ -0,0 +1,517 @@
+// bench.cpp — offline CppMonoSynth benchmark: renders the DSP engine from a
+// scripted event stream without ALSA or sockets, reports per-stage cost,
+// real-time factor and worst-case period time against the period deadline.
+// --check and --compare add an accuracy report: against the engine's scalar
+// reference paths, or against a WAV written by an earlier (golden) run;
+// tests/run.sh (make test) drives --compare over the committed goldens.
+//
+// Script lines (times in ms from start, '#' comments):
+//   <t> key <index> <vel>          same mapping as /key (1–24 keys, 0 = AUX)
+//   <t> knobs <k1> <k2> <k3> <k4> <k5>
+//   <t> aux
+//   <t> mod <slot> <source> <dest> <depth>   same as /mod; depth in 1/1000
+//       (slot 0–7; source 0 LFO, 1 env, 2 speed, 3 length, 4 release;
+//        dest 0 PW, 1 cutoff, 2 reso, 3 dist, 4 reverb)
+//   <t> preset <k1> <ratio> <k2> <k3> <k4> <k5> <waveform> [<source> <dest> <depth>]...
+//       recall a bank slot with these raw Preset fields (knobs 0–1023, up
+//       to 8 mod triples as above for slots 0–7, missing ones depth 0);
+//       decoded by decode_preset as on the device, at most 4 per script
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "dsp.h"
+
+struct ScriptEvent {
+    uint64_t frame;      // absolute frame the event lands on
+    ParamEvent ev;
+};
+
+static const int DEFAULT_KNOBS[5] = {512, 600, 700, 300, 400};   // state before t = 0
+static const double DEFAULT_MIN_SNR_DB = 60.0;
+
+static bool parse_script(FILE* f, std::vector<std::vector<int>>& rows,
+                         std::vector<double>& times, std::vector<int>& kinds) {
+    char line[256];
+    int lineNo = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '#' || *p == '\n' || *p == '\0') continue;
+        double t;
+        char cmd[16];
+        int used = 0;
+        if (sscanf(p, "%lf %15s%n", &t, cmd, &used) != 2) {
+            fprintf(stderr, "script:%d: expected <t_ms> <command>\n", lineNo);
+            return false;
+        }
+        std::vector<int> args;
+        p += used;
+        int v, adv;
+        while (sscanf(p, "%d%n", &v, &adv) == 1) { args.push_back(v); p += adv; }
+
+        int kind;
+        if      (strcmp(cmd, "key") == 0   && args.size() >= 2) kind = 0;
+        else if (strcmp(cmd, "knobs") == 0 && args.size() >= 5) kind = 1;
+        else if (strcmp(cmd, "aux") == 0)                       kind = 2;
+        else if (strcmp(cmd, "mod") == 0   && args.size() >= 4) kind = 3;
+        else if (strcmp(cmd, "preset") == 0 && args.size() >= 7
+                 && args.size() <= 7 + 3 * MOD_SLOTS && (args.size() - 7) % 3 == 0)
+            kind = 4;
+        else {
+            fprintf(stderr, "script:%d: bad command '%s'\n", lineNo, cmd);
+            return false;
+        }
+        times.push_back(t);
+        kinds.push_back(kind);
+        rows.push_back(args);
+    }
+    return true;
+}
+
+// Built-in script: a two-octave legato arpeggio with all five knobs sweeping
+// slowly, an AUX waveform change every 2 s — exercises every stage. In poly
+// mode a triad is held under the arpeggio so the whole pool is busy.
+static void builtin_script(double seconds, bool poly, std::vector<std::vector<int>>& rows,
+                           std::vector<double>& times, std::vector<int>& kinds) {
+    static const int ARP[] = {1, 5, 8, 12, 13, 17, 20, 24, 20, 17, 13, 12, 8, 5};
+    const int arpLen = (int)(sizeof(ARP) / sizeof(ARP[0]));
+    double endMs = seconds * 1000.0;
+    int step = 0;
+    for (double t = 0.0; t < endMs; t += 125.0, step++) {
+        int key = ARP[step % arpLen];
+        times.push_back(t);         kinds.push_back(0); rows.push_back({key, 100});
+        times.push_back(t + 110.0); kinds.push_back(0); rows.push_back({key, 0});
+    }
+    for (double t = 0.0; t < endMs; t += 20.0) {
+        double ph = t / endMs;
+        auto tri = [](double x) { x -= (int)x; return (int)(1023.0 * (x < 0.5 ? 2 * x : 2 - 2 * x)); };
+        times.push_back(t); kinds.push_back(1);
+        rows.push_back({tri(ph * 3.0), tri(ph * 2.0 + 0.25), tri(ph * 5.0),
+                        tri(ph * 1.5 + 0.5), 700});
+    }
+    for (double t = 2000.0; t < endMs; t += 2000.0) {
+        times.push_back(t); kinds.push_back(2); rows.push_back({});
+    }
+    if (poly) {
+        static const int CHORD[] = {1, 5, 8};
+        for (double t = 0.0; t < endMs; t += 1000.0)
+            for (int key : CHORD) {
+                times.push_back(t + 5.0);   kinds.push_back(0); rows.push_back({key, 100});
+                times.push_back(t + 900.0); kinds.push_back(0); rows.push_back({key, 0});
+            }
+    }
+}
+
+static void write_le(FILE* f, uint32_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) fputc((int)((v >> (8 * i)) & 0xff), f);
+}
+
+static void write_wav_header(FILE* f, uint32_t frames) {
+    uint32_t dataBytes = frames * CHANNELS * 2;
+    fwrite("RIFF", 1, 4, f); write_le(f, 36 + dataBytes, 4);
+    fwrite("WAVEfmt ", 1, 8, f);
+    write_le(f, 16, 4); write_le(f, 1, 2); write_le(f, CHANNELS, 2);
+    uint32_t rate = (uint32_t)g_sampleRate;
+    write_le(f, rate, 4); write_le(f, rate * CHANNELS * 2, 4);
+    write_le(f, CHANNELS * 2, 2); write_le(f, 16, 2);
+    fwrite("data", 1, 4, f); write_le(f, dataBytes, 4);
+}
+
+// Read back a --wav file: 16-bit stereo PCM at the running rate, 44-byte header
+static bool read_wav16(const char* path, std::vector<int16_t>& samples) {
+    FILE* f = fopen(path, "rb");
+    if (!f) { perror(path); return false; }
+    uint8_t h[44];
+    bool ok = fread(h, 1, sizeof(h), f) == sizeof(h)
+           && memcmp(h, "RIFF", 4) == 0 && memcmp(h + 8, "WAVEfmt ", 8) == 0
+           && memcmp(h + 36, "data", 4) == 0;
+    uint32_t rate = 0, bytes = 0;
+    if (ok) {
+        memcpy(&rate, h + 24, 4);
+        memcpy(&bytes, h + 40, 4);
+        ok = h[20] == 1 && h[22] == CHANNELS && h[34] == 16 && rate == (uint32_t)g_sampleRate;
+    }
+    if (ok) {
+        samples.resize(bytes / 2);
+        ok = fread(samples.data(), 2, samples.size(), f) == samples.size();
+    }
+    fclose(f);
+    if (!ok) fprintf(stderr, "%s: not a 16-bit stereo WAV at %u Hz\n", path, (unsigned)g_sampleRate);
+    return ok;
+}
+
+// Accuracy of a take against its reference, over every sample
+struct ErrorStats {
+    double signal = 0.0, noise = 0.0, worst = 0.0;
+    uint64_t count = 0;
+
+    void add(double got, double want) {
+        double e = got - want;
+        signal += want * want;
+        noise  += e * e;
+        if (fabs(e) > worst) worst = fabs(e);
+        count++;
+    }
+    double snrDb() const { return noise > 0.0 ? 10.0 * log10(signal / noise) : INFINITY; }
+};
+
+// Render one period into mix, applying each event on its frame
+static void render_period(Synth& synth, const std::vector<ScriptEvent>& events,
+                          size_t& evIdx, uint64_t pos, int frames, float* mix) {
+    int done = 0;
+    while (evIdx < events.size() && events[evIdx].frame < pos + frames) {
+        int at = events[evIdx].frame > pos ? (int)(events[evIdx].frame - pos) : 0;
+        if (at > done) {
+            synth.render(mix + done * CHANNELS, at - done);
+            done = at;
+        }
+        synth.apply(events[evIdx++].ev);
+    }
+    synth.render(mix + done * CHANNELS, frames - done);
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--seconds S] [--script FILE] [--wav OUT.wav] [--rate HZ]\n"
+                    "          [--format F] [--period N] [--poly] [--wavetable] [--oversample N]\n"
+                    "          [--control-interval N] [--fdn-reverb] [--tail S] [--no-ftz]\n"
+                    "          [--unison N] [--detune CENTS] [--spread S]\n"
+                    "          [--check] [--compare GOLDEN.wav] [--min-snr DB] [--max-error LSB]\n"
+                    "  --seconds S           rendered length (default 10)\n"
+                    "  --script FILE         event script (default: built-in arpeggio + knob sweeps)\n"
+                    "  --wav OUT.wav         write the rendered audio (16-bit stereo)\n"
+                    "  --rate HZ             engine sample rate (default %d)\n"
+                    "  --format F            timed output conversion: s16, s24, s32, float (default s16)\n"
+                    "  --period N            frames per render call / deadline (1-%d, default %d)\n"
+                    "  --poly                %d-voice polyphonic mode\n"
+                    "  --wavetable           band-limited wavetable oscillators instead of PolyBLEP\n"
+                    "  --unison N            mono mode: stack of N (2-%d) detuned PolyBLEP copies\n"
+                    "  --detune CENTS        unison stack width, +/- cents (default %.0f)\n"
+                    "  --spread S            unison stereo spread 0-1 (default %.1f)\n"
+                    "  --oversample N        run heavy distortion at 2x or 4x (default 1 = off)\n"
+                    "  --fdn-reverb          8-line FDN reverb instead of the Schroeder bank\n"
+                    "  --tail S              release all notes at the end, then time S s of tail\n"
+                    "  --no-ftz              leave the FPU's denormal handling as it is\n"
+                    "  --control-interval N  k-rate parameter period in samples (1-%d, default %d)\n"
+                    "  --check               also render through the scalar reference (per-sample\n"
+                    "                        voice and reverb, same k-rate points) and compare;\n"
+                    "                        mono, Schroeder reverb\n"
+                    "  --compare GOLDEN.wav  compare the 16-bit output with an earlier --wav\n"
+                    "  --min-snr DB          accuracy threshold for both (default %.0f); exit 1 below\n"
+                    "  --max-error LSB       --compare also fails on any sample off by more (default off)\n",
+            argv0, SAMPLE_RATE, MAX_PERIOD_FRAMES, PERIOD_FRAMES, POLY_VOICES,
+            UNISON_MAX, UNISON_DETUNE, UNISON_SPREAD, BLOCK_FRAMES, CONTROL_INTERVAL,
+            DEFAULT_MIN_SNR_DB);
+}
+
+int main(int argc, char** argv) {
+    double seconds = 10.0;
+    double tailSeconds = 0.0;
+    bool   ftz = true;
+    const char* scriptPath = nullptr;
+    const char* wavPath = nullptr;
+    bool useWavetable = false;
+    bool polyMode = false;
+    bool fdnReverb = false;
+    int  unison = 0;
+    float detune = UNISON_DETUNE, spread = UNISON_SPREAD;
+    int  oversample = 1;
+    int  controlInterval = CONTROL_INTERVAL;
+    bool check = false;
+    const char* comparePath = nullptr;
+    double minSnrDb = DEFAULT_MIN_SNR_DB;
+    double maxErrorLsb = INFINITY;
+    int  rate = SAMPLE_RATE;
+    int  period = PERIOD_FRAMES;
+    SampleFormat format = FMT_S16;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--seconds") == 0 && a + 1 < argc) seconds = atof(argv[++a]);
+        else if (strcmp(argv[a], "--script") == 0 && a + 1 < argc) scriptPath = argv[++a];
+        else if (strcmp(argv[a], "--wav") == 0 && a + 1 < argc) wavPath = argv[++a];
+        else if (strcmp(argv[a], "--rate") == 0 && a + 1 < argc) rate = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--period") == 0 && a + 1 < argc) period = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--format") == 0 && a + 1 < argc) {
+            const char* f = argv[++a];
+            if      (strcmp(f, "s16") == 0)   format = FMT_S16;
+            else if (strcmp(f, "s24") == 0)   format = FMT_S24;
+            else if (strcmp(f, "s32") == 0)   format = FMT_S32;
+            else if (strcmp(f, "float") == 0) format = FMT_FLOAT;
+            else { usage(argv[0]); return 7; }
+        }
+        else if (strcmp(argv[a], "--wavetable") == 0) useWavetable = true;
+        else if (strcmp(argv[a], "--poly") == 0) polyMode = true;
+        else if (strcmp(argv[a], "--fdn-reverb") == 0) fdnReverb = true;
+        else if (strcmp(argv[a], "--unison") == 0 && a + 1 < argc) unison = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--detune") == 0 && a + 1 < argc) detune = atof(argv[++a]);
+        else if (strcmp(argv[a], "--spread") == 0 && a + 1 < argc) spread = atof(argv[++a]);
+        else if (strcmp(argv[a], "--check") == 0) check = true;
+        else if (strcmp(argv[a], "--compare") == 0 && a + 1 < argc) comparePath = argv[++a];
+        else if (strcmp(argv[a], "--min-snr") == 0 && a + 1 < argc) minSnrDb = atof(argv[++a]);
+        else if (strcmp(argv[a], "--max-error") == 0 && a + 1 < argc) maxErrorLsb = atof(argv[++a]);
+        else if (strcmp(argv[a], "--tail") == 0 && a + 1 < argc) tailSeconds = atof(argv[++a]);
+        else if (strcmp(argv[a], "--no-ftz") == 0) ftz = false;
+        else if (strcmp(argv[a], "--oversample") == 0 && a + 1 < argc)
+            oversample = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--control-interval") == 0 && a + 1 < argc)
+            controlInterval = atoi(argv[++a]);
+        else { usage(argv[0]); return 7; }
+    }
+    if (seconds <= 0.0 || tailSeconds < 0.0 || controlInterval < 1 || controlInterval > BLOCK_FRAMES
+        || rate < 8000 || rate > MAX_SAMPLE_RATE || period < 1 || period > MAX_PERIOD_FRAMES
+        || (unison != 0 && (unison < 2 || unison > UNISON_MAX || polyMode))
+        || detune < 0.0f || detune > 100.0f || spread < 0.0f || spread > 1.0f
+        || (check && (polyMode || unison || fdnReverb))) {
+        usage(argv[0]);
+        return 7;
+    }
+    set_sample_rate((unsigned)rate);   // before any DSP object or knob decoding
+    if (ftz) enable_flush_to_zero();    // as the audio thread does
+    probe_init();                       // make PROBES=1 only
+
+    // ── Script → absolute-frame ParamEvents (knobs decoded as on the device) ──
+    std::vector<std::vector<int>> rows;
+    std::vector<double> times;
+    std::vector<int> kinds;
+    if (scriptPath) {
+        FILE* f = fopen(scriptPath, "r");
+        if (!f) { perror(scriptPath); return 1; }
+        bool ok = parse_script(f, rows, times, kinds);
+        fclose(f);
+        if (!ok) return 1;
+    } else {
+        builtin_script(seconds, polyMode, rows, times, kinds);
+    }
+
+    // Stable sort by time so decode order (waveform state) follows the timeline
+    std::vector<size_t> order(times.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t x, size_t y) { return times[x] < times[y]; });
+
+    std::vector<ScriptEvent> events;
+    ParamQueue q;
+    static PatchPool patches;   // one slot per preset line, never reused
+    uint32_t presetCount = 0;
+    int waveform = 0;
+    float dispPortoMs, dispRatio, dispCutoffHz, dispReso, dispReleaseMs;
+    knobs_to_events(q, 0, waveform, DEFAULT_KNOBS[0], DEFAULT_KNOBS[1], DEFAULT_KNOBS[2],
+                    DEFAULT_KNOBS[3], DEFAULT_KNOBS[4],
+                    dispPortoMs, dispRatio, dispCutoffHz, dispReso, dispReleaseMs);
+    for (size_t oi = 0; oi < order.size(); oi++) {
+        size_t i = order[oi];
+        uint64_t tNs = (uint64_t)(times[i] * 1e6);
+        const std::vector<int>& r = rows[i];
+        if (kinds[i] == 0) {
+            int index = r[0], vel = r[1];
+            if (index > 0 && index < 25)
+                q.push({vel > 0 ? ParamEvent::NOTE_ON : ParamEvent::NOTE_OFF,
+                        index + 59, 0.0f, 0.0f, tNs});
+            else if (index == 0 && vel > 0)
+                kinds[i] = 2;
+        } else if (kinds[i] == 1) {
+            knobs_to_events(q, tNs, waveform, r[0], r[1], r[2], r[3], r[4],
+                            dispPortoMs, dispRatio, dispCutoffHz, dispReso, dispReleaseMs);
+        }
+        if (kinds[i] == 2) {
+            waveform = (waveform + 1) % NUM_WAVEFORMS;
+            q.push({ParamEvent::WAVEFORM, waveform, 0.0f, 0.0f, tNs});
+        }
+        if (kinds[i] == 3)   // mod <slot> <source> <dest> <depth in 1/1000>
+            q.push({ParamEvent::MOD_ROUTE, (r[0] & 0xff) | (r[1] & 0xff) << 8 | (r[2] & 0xff) << 16,
+                    r[3] * 0.001f, 0.0f, tNs});
+        if (kinds[i] == 4) {
+            if (presetCount == PatchPool::SIZE) {
+                fprintf(stderr, "script: more than %u preset lines\n", PatchPool::SIZE);
+                return 1;
+            }
+            Preset p = {};
+            p.porta = (uint16_t)r[0];  p.ratio  = (uint16_t)r[1];
+            p.cutoff = (uint16_t)r[2]; p.reso   = (uint16_t)r[3];
+            p.release = (uint16_t)r[4]; p.volume = (uint16_t)r[5];
+            p.waveform = (uint8_t)r[6];
+            p.used = 1;
+            for (size_t k = 0; 7 + 3 * k < r.size(); k++) {
+                p.modSource[k] = (uint8_t)r[7 + 3 * k];
+                p.modDest[k]   = (uint8_t)r[8 + 3 * k];
+                p.modDepth[k]  = r[9 + 3 * k] * 0.001f;
+            }
+            decode_preset(p, patches.slot[presetCount]);
+            waveform = p.waveform % NUM_WAVEFORMS;   // later knobs decode in its mode
+            q.push({ParamEvent::PATCH, (int32_t)presetCount++, 0.0f, 0.0f, tNs});
+        }
+        ParamEvent ev;
+        while (q.pop(ev))
+            events.push_back({ev.timeNs * (uint64_t)rate / 1000000000ull, ev});
+    }
+
+    // Silent tail: drop anything scripted past the end, release every key there
+    const uint64_t totalFrames = (uint64_t)(seconds * rate);
+    const uint64_t tailFrames  = (uint64_t)(tailSeconds * rate);
+    if (tailFrames > 0) {
+        while (!events.empty() && events.back().frame >= totalFrames) events.pop_back();
+        for (int note = 60; note < 84; note++)
+            events.push_back({totalFrames, {ParamEvent::NOTE_OFF, note, 0.0f, 0.0f, 0}});
+    }
+
+    std::vector<int16_t> golden;
+    if (comparePath && !read_wav16(comparePath, golden)) return 1;
+
+    // ── Engine ──
+    static Wavetables wavetables;
+    if (useWavetable) wavetables.init();
+    auto setup = [&](Synth& s, int interval) {
+        s.init(interval, polyMode, fdnReverb);
+        if (useWavetable) s.setWavetables(&wavetables);
+        s.setUnison(unison, detune, spread);
+        s.setOversample(oversample);
+        s.patches = &patches;
+    };
+    Synth synth;
+    setup(synth, controlInterval);
+    StageClock clock;
+    synth.setClock(&clock);
+
+    FILE* wav = nullptr;
+    if (wavPath) {
+        wav = fopen(wavPath, "wb");
+        if (!wav) { perror(wavPath); return 1; }
+        write_wav_header(wav, 0);
+    }
+
+    // ── Render, one period at a time, splitting at event frames ──
+    // (the tail is timed on its own and kept out of the stage breakdown)
+    const double   deadlineUs  = 1e6 * period / rate;
+    static float   mix[MAX_PERIOD_FRAMES * CHANNELS];
+    static int32_t dev[MAX_PERIOD_FRAMES * CHANNELS];   // device-format output (≤ 4 bytes/sample)
+    static int16_t out[MAX_PERIOD_FRAMES * CHANNELS];
+    uint64_t worstNs = 0, totalNs = 0, overDeadline = 0;
+    uint64_t tailWorstNs = 0, tailNs = 0;
+    StageClock* clk = &clock;
+    size_t evIdx = 0;
+    const uint64_t endFrames = totalFrames + tailFrames;
+    std::vector<float> take;   // whole render, kept for the accuracy checks
+    if (check || comparePath) take.reserve(endFrames * CHANNELS);
+    for (uint64_t pos = 0; pos < endFrames; pos += period) {
+        int frames = (int)((endFrames - pos < (uint64_t)period)
+                           ? endFrames - pos : period);
+        // A period straddling the boundary still counts as scripted
+        if (pos >= totalFrames && clk) {
+            clk = nullptr;
+            synth.setClock(nullptr);
+        }
+        uint64_t t0 = now_ns();
+        render_period(synth, events, evIdx, pos, frames, mix);
+        convert_samples(mix, dev, frames * CHANNELS, format);
+        STAGE_LAP(clk, STAGE_CONVERT);
+        uint64_t dt = now_ns() - t0;
+
+        if (!clk) {
+            tailNs += dt;
+            if (dt > tailWorstNs) tailWorstNs = dt;
+        } else {
+            totalNs += dt;
+            if (dt > worstNs) worstNs = dt;
+            if (dt * 1e-3 > deadlineUs * frames / period) overDeadline++;
+        }
+        if (wav) {
+            convert_samples(mix, out, frames * CHANNELS, FMT_S16);
+            fwrite(out, sizeof(int16_t) * CHANNELS, frames, wav);
+        }
+        if (check || comparePath) take.insert(take.end(), mix, mix + frames * CHANNELS);
+    }
+
+    if (wav) {
+        fseek(wav, 0, SEEK_SET);
+        write_wav_header(wav, (uint32_t)endFrames);
+        fclose(wav);
+    }
+
+    // ── Report ──
+    double audioSec = (double)totalFrames / rate;
+    uint64_t stageSum = 0;
+    for (int s = 0; s < NUM_STAGES; s++) stageSum += clock.ns[s];
+    printf("rendered %.2f s at %d Hz %s, %d-frame periods (%llu frames, %zu events)\n",
+           audioSec, rate, FORMAT_NAMES[format], period,
+           (unsigned long long)totalFrames, events.size());
+    char mode[48];
+    if (unison) snprintf(mode, sizeof(mode), "mono, unison %d x +/-%.0f cents", unison, detune);
+    else        snprintf(mode, sizeof(mode), "%s", polyMode ? "poly" : "mono");
+    printf("%s, %s, %dx dist, %s reverb, control interval %d\n",
+           mode, unison || !useWavetable ? "polyblep" : "wavetable",
+           synth.dist.osFactor, fdnReverb ? "fdn" : "schroeder", controlInterval);
+    printf("%-10s %10s %7s\n", "stage", "ns/sample", "share");
+    for (int s = 0; s < NUM_STAGES; s++)
+        printf("%-10s %10.2f %6.1f%%\n", STAGE_NAMES[s],
+               (double)clock.ns[s] / totalFrames,
+               stageSum ? 100.0 * clock.ns[s] / stageSum : 0.0);
+    printf("%-10s %10.2f\n", "total", (double)totalNs / totalFrames);
+    printf("real-time factor: %.1fx (%.2f%% DSP load)\n",
+           audioSec * 1e9 / totalNs, 100.0 * totalNs / (audioSec * 1e9));
+    printf("worst period: %.1f us of %.1f us deadline (%.2f%%), %llu over\n",
+           worstNs * 1e-3, deadlineUs, 100.0 * worstNs * 1e-3 / deadlineUs,
+           (unsigned long long)overDeadline);
+    if (tailFrames > 0)
+        printf("silent tail %.1f s (ftz %s): %.2f ns/sample, worst period %.1f us\n",
+               tailSeconds, ftz ? "on" : "off", (double)tailNs / tailFrames, tailWorstNs * 1e-3);
+    fflush(stdout);
+    probe_dump(stdout);
+
+    // ── Accuracy ──
+    // SNR over the whole take; worst error in dBFS (±MASTER_GAIN) or in LSBs
+    bool pass = true;
+    auto dbfs = [](double worst) { return worst > 0.0 ? 20.0 * log10(worst / MASTER_GAIN) : -INFINITY; };
+    if (check) {
+        // The take against the scalar reference path with k-rate points at
+        // `interval`
+        auto against = [&](int interval) {
+            Synth ref;
+            setup(ref, interval);
+            ref.reference = true;
+            ErrorStats e;
+            size_t refIdx = 0;
+            for (uint64_t pos = 0; pos < endFrames; pos += period) {
+                int frames = (int)((endFrames - pos < (uint64_t)period)
+                                   ? endFrames - pos : period);
+                render_period(ref, events, refIdx, pos, frames, mix);
+                const float* got = &take[pos * CHANNELS];
+                for (int i = 0; i < frames * CHANNELS; i++) e.add(got[i], mix[i]);
+            }
+            return e;
+        };
+        // Gated: the block/SIMD paths against per-sample rendering of the
+        // same control schedule
+        ErrorStats e = against(controlInterval);
+        bool ok = e.snrDb() >= minSnrDb;
+        printf("check vs scalar reference: SNR %.1f dB, worst error %.1f dBFS, %s\n",
+               e.snrDb(), dbfs(e.worst), ok ? "pass" : "FAIL");
+        pass = pass && ok;
+        // Informational: what the control interval itself costs against
+        // smoothing every sample (a tuning trade-off, not a defect)
+        if (controlInterval > 1) {
+            ErrorStats k = against(1);
+            printf("k-rate %d vs every sample: SNR %.1f dB, worst error %.1f dBFS\n",
+                   controlInterval, k.snrDb(), dbfs(k.worst));
+        }
+    }
+    if (comparePath) {
+        ErrorStats e;
+        uint64_t frames = golden.size() / CHANNELS < endFrames ? golden.size() / CHANNELS : endFrames;
+        for (uint64_t f = 0; f < frames; f += MAX_PERIOD_FRAMES) {
+            int m = (int)(frames - f < (uint64_t)MAX_PERIOD_FRAMES ? frames - f : MAX_PERIOD_FRAMES);
+            convert_samples(&take[f * CHANNELS], out, m * CHANNELS, FMT_S16);
+            for (int i = 0; i < m * CHANNELS; i++) e.add(out[i], golden[f * CHANNELS + i]);
+        }
+        bool sameLength = golden.size() == endFrames * CHANNELS;
+        bool ok = sameLength && e.snrDb() >= minSnrDb && e.worst <= maxErrorLsb;
+        printf("compare vs %s: SNR %.1f dB, worst error %.0f LSB%s, %s\n", comparePath,
+               e.snrDb(), e.worst, sameLength ? "" : " (length differs)", ok ? "pass" : "FAIL");
+        pass = pass && ok;
+    }
+    return pass ? 0 : 1;
+}
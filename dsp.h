@@ -0,0 +1,2748 @@
+// dsp.h — CppMonoSynth DSP engine: everything the audio thread runs
+// No ALSA or socket dependencies, so the bench harness links the same code.
+
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <time.h>
+
+#if MONOSYNTH_PROBES
+#include <csetjmp>
+#include <csignal>
+#endif
+
+#include "fastmath.h"
+
+// ─── Constants ───────────────────────────────────────────────────────────────
+
+static constexpr int    SAMPLE_RATE         = 44100;   // requested; the engine runs at the granted rate
+static constexpr int    MAX_SAMPLE_RATE     = 96000;   // sizes the reverb delay lines
+static constexpr int    PERIOD_FRAMES       = 128;    // default; --period overrides
+static constexpr int    MAX_PERIOD_FRAMES   = 2048;   // sizes the per-period buffers
+static constexpr int    BLOCK_FRAMES        = 128;   // DSP scratch buffer size
+static constexpr int    CHANNELS            = 2;
+static constexpr int    NOTE_STACK_SZ       = 16;
+static constexpr float  TWO_PI              = 6.283185307f;
+static constexpr float  PI                  = 3.141592654f;
+static constexpr float  ATTACK_MS           = 5.0f;
+static constexpr int    NUM_WAVEFORMS       = 4;
+static constexpr float  PARAM_SMOOTH_COEFF = 0.002f;
+static constexpr int    CONTROL_INTERVAL   = 16;      // default k-rate period (samples)
+static constexpr float  MASTER_GAIN        = 0.35f;   // match Pd patch output level
+
+// Runtime sample rate. set_sample_rate() must run before any DSP object is
+// constructed (constructors and init() derive coefficients from it).
+static float g_sampleRate = (float)SAMPLE_RATE;
+static float g_invSR      = 1.0f / SAMPLE_RATE;
+
+static inline void set_sample_rate(unsigned rate) {
+    if (rate < 8000) rate = 8000;
+    if (rate > (unsigned)MAX_SAMPLE_RATE) rate = MAX_SAMPLE_RATE;
+    g_sampleRate = (float)rate;
+    g_invSR      = 1.0f / (float)rate;
+}
+
+// ─── Monotonic clock + per-stage timing (bench / diagnostics) ───────────────
+
+static inline uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+enum Stage {
+    STAGE_CONTROL,   // k-rate ramps, PWM LFO, play-style dynamics
+    STAGE_OSC,       // portamento, morph, oscillator
+    STAGE_FILTER,
+    STAGE_ENV,
+    STAGE_DIST,
+    STAGE_REVERB,
+    STAGE_OUTPUT,    // volume, clip, peak, interleave
+    STAGE_CONVERT,   // float → device format (caller-side, after render)
+    NUM_STAGES
+};
+
+static const char* const STAGE_NAMES[NUM_STAGES] = {
+    "control", "osc", "filter", "env", "dist", "reverb", "output", "convert"
+};
+
+// Accumulates wall time per stage between lap() calls. DSP structs hold a
+// nullable pointer to one; production leaves it null (one branch per stage).
+struct StageClock {
+    uint64_t ns[NUM_STAGES] = {};
+    uint64_t last = 0;
+
+    void start() { last = now_ns(); }
+    void lap(int stage) {
+        uint64_t t = now_ns();
+        ns[stage] += t - last;
+        last = t;
+    }
+};
+
+#define STAGE_LAP(clk, st) do { if (clk) (clk)->lap(st); } while (0)
+
+// ─── Probes (per-stage profiler, compiled in with make PROBES=1) ───────────
+// PROBE(id) times its enclosing scope into a per-probe counter: the ARM
+// cycle counter (PMCCNTR) where the kernel lets user space read it, else
+// CLOCK_MONOTONIC. Each probe is only ever hit from one thread, so the
+// counters are single-writer atomics (relaxed load + store, no RMW) that
+// probe_dump() can read from any thread. Without PROBES it expands to nothing.
+
+enum ProbeId {
+    PROBE_RENDER,    // Synth::render, whole call
+    PROBE_OSC,       // Oscillator / UnisonOsc block
+    PROBE_POOL,      // poly pool block (osc, filter and envelope fused)
+    PROBE_FILTER,    // SVFilter block
+    PROBE_DIST,
+    PROBE_REVERB,    // Schroeder or FDN block
+    PROBE_OSC_IN,    // control thread: one recvmmsg batch + dispatch
+    PROBE_OLED,      // control thread: one display frame
+    NUM_PROBES
+};
+
+static const char* const PROBE_NAMES[NUM_PROBES] = {
+    "render", "osc", "pool", "filter", "dist", "reverb", "osc-in", "oled"
+};
+
+#if MONOSYNTH_PROBES
+
+struct ProbeStat {
+    std::atomic<uint32_t> calls{0};
+    std::atomic<uint32_t> min{UINT32_MAX};
+    std::atomic<uint32_t> max{0};
+    std::atomic<uint64_t> sum{0};
+
+    void add(uint32_t t) {
+        calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum.store(sum.load(std::memory_order_relaxed) + t, std::memory_order_relaxed);
+        if (t < min.load(std::memory_order_relaxed)) min.store(t, std::memory_order_relaxed);
+        if (t > max.load(std::memory_order_relaxed)) max.store(t, std::memory_order_relaxed);
+    }
+};
+
+static ProbeStat g_probes[NUM_PROBES];
+static bool      g_probeCycles = false;   // PMCCNTR readable (set by probe_init)
+
+#if defined(__arm__) || defined(__aarch64__)
+static inline uint32_t probe_cycles() {
+    uint64_t v;
+#if defined(__aarch64__)
+    asm volatile("mrs %0, pmccntr_el0" : "=r"(v));
+#else
+    uint32_t c;
+    asm volatile("mrc p15, 0, %0, c9, c13, 0" : "=r"(c));
+    v = c;
+#endif
+    return (uint32_t)v;
+}
+
+static sigjmp_buf g_probeJmp;
+static void probe_sigill(int) { siglongjmp(g_probeJmp, 1); }
+#endif
+
+// Low 32 bits are enough: a scope is far shorter than one wrap
+static inline uint32_t probe_ticks() {
+#if defined(__arm__) || defined(__aarch64__)
+    if (g_probeCycles) return probe_cycles();
+#endif
+    return (uint32_t)now_ns();
+}
+
+// Once, before any probe runs: user-space PMCCNTR access traps (SIGILL)
+// unless the kernel enabled it, and the counter may be stopped (PMCR.E)
+static void probe_init() {
+#if defined(__arm__) || defined(__aarch64__)
+    struct sigaction sa = {}, old;
+    sa.sa_handler = probe_sigill;
+    sigaction(SIGILL, &sa, &old);
+    if (sigsetjmp(g_probeJmp, 1) == 0) {
+        uint32_t a = probe_cycles();
+        for (volatile int i = 0; i < 1000; i++) {}
+        g_probeCycles = probe_cycles() != a;
+    }
+    sigaction(SIGILL, &old, nullptr);
+#endif
+}
+
+static void probe_dump(FILE* f) {
+    const char* unit = g_probeCycles ? "cycles" : "ns";
+    uint64_t renderSum = g_probes[PROBE_RENDER].sum.load(std::memory_order_relaxed);
+    fprintf(f, "probes (%s per call):\n%-8s %10s %10s %10s %10s %7s\n",
+            unit, "probe", "calls", "min", "avg", "max", "render");
+    for (int p = 0; p < NUM_PROBES; p++) {
+        const ProbeStat& s = g_probes[p];
+        uint32_t calls = s.calls.load(std::memory_order_relaxed);
+        if (calls == 0) continue;
+        uint64_t sum = s.sum.load(std::memory_order_relaxed);
+        char share[16] = "-";
+        if (p <= PROBE_REVERB && renderSum)
+            snprintf(share, sizeof(share), "%.1f%%", 100.0 * sum / renderSum);
+        fprintf(f, "%-8s %10u %10u %10.0f %10u %7s\n", PROBE_NAMES[p], calls,
+                s.min.load(std::memory_order_relaxed), (double)sum / calls,
+                s.max.load(std::memory_order_relaxed), share);
+    }
+}
+
+struct ProbeScope {
+    ProbeStat& stat;
+    uint32_t   t0;
+    explicit ProbeScope(ProbeId id) : stat(g_probes[id]), t0(probe_ticks()) {}
+    ~ProbeScope() { stat.add(probe_ticks() - t0); }
+};
+
+#define PROBE_CAT2(a, b) a##b
+#define PROBE_CAT(a, b)  PROBE_CAT2(a, b)
+#define PROBE(id) ProbeScope PROBE_CAT(probe_, __LINE__)(id)
+
+#else
+
+static inline void probe_init() {}
+static inline void probe_dump(FILE*) {}
+#define PROBE(id) ((void)0)
+
+#endif
+
+// ─── SIMD (GCC vector extensions → NEON q-regs on the A9, SSE on x86) ───────
+
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__SSE2__)) \
+    && !defined(MONOSYNTH_NO_SIMD)
+#define MONOSYNTH_SIMD 1
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#else
+#include <emmintrin.h>
+#endif
+#else
+#define MONOSYNTH_SIMD 0
+#endif
+
+typedef float   v4f __attribute__((vector_size(16)));
+typedef int32_t v4i __attribute__((vector_size(16)));
+
+static inline v4f v4f_set1(float x) { return v4f{x, x, x, x}; }
+
+// ─── Denormal protection ────────────────────────────────────────────────────
+// Two layers. enable_flush_to_zero() puts the calling thread's FPU in
+// flush-to-zero + default-NaN (FPSCR FZ|DN on ARM VFP, where the A9's
+// scalar unit otherwise traps to slow microcode; NEON always flushes) or
+// FTZ|DAZ on x86. Independently, recursive state is threshold-flushed at
+// block ends, so it can't park in the denormal range even if the mode
+// isn't set. Delay lines need neither: Activity clears them at -100 dB.
+
+#if defined(__SSE__) && !MONOSYNTH_SIMD
+#include <xmmintrin.h>
+#endif
+
+static constexpr float DENORMAL_FLOOR = 1e-15f;   // -300 dB, far above FLT_MIN
+
+static inline void enable_flush_to_zero() {
+#if defined(__aarch64__)
+    uint64_t fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    fpcr |= (1ull << 24) | (1ull << 25);   // FZ, DN
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+#elif defined(__arm__) && defined(__ARM_FP)
+    uint32_t fpscr;
+    __asm__ __volatile__("vmrs %0, fpscr" : "=r"(fpscr));
+    fpscr |= (1u << 24) | (1u << 25);      // FZ, DN
+    __asm__ __volatile__("vmsr fpscr, %0" : : "r"(fpscr));
+#elif defined(__SSE__)
+    _mm_setcsr(_mm_getcsr() | 0x8040);     // FTZ, DAZ
+#endif
+}
+
+static inline float flush_denormal(float x) {
+    return fabsf(x) < DENORMAL_FLOOR ? 0.0f : x;
+}
+
+// Lane-wise, branch-free: keep lanes whose magnitude bits reach the floor
+// (positive floats order like their bit patterns)
+static inline v4f flush_denormal(v4f v) {
+    const v4i absMask = {0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff};
+    const v4i floor   = {0x26901d7d, 0x26901d7d, 0x26901d7d, 0x26901d7d};   // 1e-15f
+    v4i bits = (v4i)v;
+    return (v4f)(bits & ((bits & absMask) >= floor));
+}
+
+// ─── Activity tracking (idle stages skip their work) ────────────────────────
+// A stage goes idle after HOLD_SECS of consecutive blocks below SILENCE and
+// wakes on the first louder block — or explicitly, on a note-on.
+
+static inline float block_peak(const float* buf, int n) {
+    float p = 0.0f;
+    for (int i = 0; i < n; i++) {
+        float a = fabsf(buf[i]);
+        if (a > p) p = a;
+    }
+    return p;
+}
+
+struct Activity {
+    static constexpr float SILENCE   = 1e-5f;   // ~-100 dBFS, under the S16 LSB at full volume
+    static constexpr float HOLD_SECS = 0.1f;    // longer than any reverb delay path
+    int quiet = 0;                              // consecutive quiet samples
+    int hold  = (int)(HOLD_SECS * g_sampleRate);
+
+    bool idle() const { return quiet >= hold; }
+    void wake() { quiet = 0; }
+
+    // Block of n samples with the given peak; true on the block that makes
+    // the stage idle
+    bool update(float peak, int n) {
+        if (peak > SILENCE) { quiet = 0; return false; }
+        if (quiet >= hold) return false;
+        quiet += n;
+        return quiet >= hold;
+    }
+};
+
+// ─── Output formats: float → PCM with saturation (vectorised batch stage) ───
+
+enum SampleFormat { FMT_S16, FMT_S24, FMT_S32, FMT_FLOAT };   // S24 = low 3 bytes of 32
+
+static const char* const FORMAT_NAMES[] = {"S16_LE", "S24_LE", "S32_LE", "FLOAT_LE"};
+
+static inline int format_bytes(SampleFormat f) { return f == FMT_S16 ? 2 : 4; }
+
+// Full-scale multipliers; S32 uses the largest float below 2^31 so a
+// clamped ±1.0 never overflows
+static inline float format_scale(SampleFormat f) {
+    return f == FMT_S16 ? 32767.0f : (f == FMT_S24 ? 8388607.0f : 2147483520.0f);
+}
+
+// n samples from in (nominally ±1) to out in format f: clamp, scale,
+// truncate toward zero. GCC 6 vector extensions have no float→int lane
+// conversion, so the SIMD path uses NEON/SSE2 intrinsics directly.
+static void convert_samples(const float* in, void* out, int n, SampleFormat f) {
+    if (f == FMT_FLOAT) {
+        float* o = (float*)out;
+        for (int i = 0; i < n; i++)
+            o[i] = in[i] > 1.0f ? 1.0f : (in[i] < -1.0f ? -1.0f : in[i]);
+        return;
+    }
+    const float scale = format_scale(f);
+    int i = 0;
+#if MONOSYNTH_SIMD && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+    const float32x4_t lo = vdupq_n_f32(-1.0f), hi = vdupq_n_f32(1.0f);
+    const float32x4_t sc = vdupq_n_f32(scale);
+    for (; i + 8 <= n; i += 8) {
+        float32x4_t a = vmulq_f32(vminq_f32(vmaxq_f32(vld1q_f32(in + i), lo), hi), sc);
+        float32x4_t b = vmulq_f32(vminq_f32(vmaxq_f32(vld1q_f32(in + i + 4), lo), hi), sc);
+        int32x4_t ia = vcvtq_s32_f32(a), ib = vcvtq_s32_f32(b);
+        if (f == FMT_S16) {
+            vst1q_s16((int16_t*)out + i, vcombine_s16(vqmovn_s32(ia), vqmovn_s32(ib)));
+        } else {
+            vst1q_s32((int32_t*)out + i, ia);
+            vst1q_s32((int32_t*)out + i + 4, ib);
+        }
+    }
+#elif MONOSYNTH_SIMD && defined(__SSE2__)
+    const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+    const __m128 sc = _mm_set1_ps(scale);
+    for (; i + 8 <= n; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), lo), hi), sc);
+        __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), lo), hi), sc);
+        __m128i ia = _mm_cvttps_epi32(a), ib = _mm_cvttps_epi32(b);
+        if (f == FMT_S16) {
+            _mm_storeu_si128((__m128i*)((int16_t*)out + i), _mm_packs_epi32(ia, ib));
+        } else {
+            _mm_storeu_si128((__m128i*)((int32_t*)out + i), ia);
+            _mm_storeu_si128((__m128i*)((int32_t*)out + i + 4), ib);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        float x = in[i] > 1.0f ? 1.0f : (in[i] < -1.0f ? -1.0f : in[i]);
+        int32_t v = (int32_t)(x * scale);
+        if (f == FMT_S16) ((int16_t*)out)[i] = (int16_t)v;
+        else              ((int32_t*)out)[i] = v;
+    }
+}
+
+// ─── PolyBLEP residual ──────────────────────────────────────────────────────
+
+static inline float polyblep(float phase, float dt) {
+    if (phase < dt) {
+        float t = phase / dt;
+        return t + t - t * t - 1.0f;
+    }
+    if (phase > 1.0f - dt) {
+        float t = (phase - 1.0f) / dt;
+        return t * t + t + t + 1.0f;
+    }
+    return 0.0f;
+}
+
+static inline v4f v4f_select(v4i m, v4f a, v4f b) {
+    return (v4f)(((v4i)a & m) | ((v4i)b & ~m));
+}
+
+// Phase wrap into [0, 1) for 0 <= x < 2^22, same result as x - floorf(x):
+// adding 1.5·2^23 rounds to an integer, corrected down where it rounded up
+static inline v4f v4f_wrap_phase(v4f x) {
+    const v4f one = v4f_set1(1.0f), magic = v4f_set1(12582912.0f);
+    v4f r = (x + magic) - magic;
+    r = v4f_select(r > x, r - one, r);
+    return v4f_select(x >= one, x - r, x);
+}
+
+static inline v4f v4f_polyblep(v4f t, v4f dt, v4f invDt) {
+    const v4f one = v4f_set1(1.0f), zero = v4f_set1(0.0f);
+    v4f lo = t * invDt;
+    v4f hi = (t - one) * invDt;
+    v4f rLo = lo + lo - lo * lo - one;
+    v4f rHi = hi * hi + hi + hi + one;
+    return v4f_select(t < dt, rLo, v4f_select(t > one - dt, rHi, zero));
+}
+
+// One waveform on four independent phases (poly voices, unison copies):
+// PolyBLEP saw/pulse, naive triangle, sine-swept pulse width for ratio PWM
+static inline v4f v4f_blep_wave(int idx, v4f ph, v4f pwmPh, v4f dt, v4f invDt, float pw) {
+    const v4f one = v4f_set1(1.0f);
+    switch (idx) {
+    case 1:
+    case 3: {
+        v4f pwv = v4f_set1(pw);
+        if (idx == 3)
+            for (int v = 0; v < 4; v++)
+                pwv[v] = 0.5f + 0.4f * dsp_sin(TWO_PI * pwmPh[v]);
+        v4f s = v4f_select(ph < pwv, one, -one) + v4f_polyblep(ph, dt, invDt);
+        v4f sh = ph - pwv;
+        sh = v4f_select(sh < v4f_set1(0.0f), sh + one, sh);
+        return s - v4f_polyblep(sh, dt, invDt);
+    }
+    case 2:
+        return v4f_select(ph < v4f_set1(0.5f), 4.0f * ph - one, 3.0f - 4.0f * ph);
+    default:
+        return 2.0f * ph - one - v4f_polyblep(ph, dt, invDt);
+    }
+}
+
+// ─── Band-limited wavetables (one mipmap level per octave) ──────────────────
+// Saw and triangle are built additively at startup; pulse/ratio-PWM are the
+// difference of two phase-shifted saw reads, so PWM stays continuous.
+
+struct Wavetables {
+    static constexpr int   SIZE    = 2048;   // power of two
+    static constexpr int   OCTAVES = 10;     // level k covers 20·2^k – 20·2^(k+1) Hz
+    static constexpr float BASE_HZ = 20.0f;
+
+    float saw[OCTAVES][SIZE + 1];   // +1 guard point for interpolation
+    float tri[OCTAVES][SIZE + 1];
+    float sine[SIZE + 1];
+
+    void init() {
+        for (int i = 0; i <= SIZE; i++)
+            sine[i] = sinf(TWO_PI * (float)i / SIZE);
+
+        for (int k = 0; k < OCTAVES; k++) {
+            // Highest harmonic below Nyquist at the top of this octave
+            int nh = (int)(0.5f * g_sampleRate / (BASE_HZ * (float)(2 << k)));
+            if (nh > SIZE / 2 - 1) nh = SIZE / 2 - 1;
+            if (nh < 1) nh = 1;
+            for (int i = 0; i < SIZE; i++) {
+                // sin(2π·h·i/SIZE) = sine[(h·i) mod SIZE]: additions only
+                float sSaw = 0.0f, sTri = 0.0f;
+                for (int h = 1; h <= nh; h++) {
+                    sSaw += sine[(h * i) & (SIZE - 1)] / (float)h;
+                    if (h & 1)  // cos = sin shifted by a quarter period
+                        sTri += sine[(h * i + SIZE / 4) & (SIZE - 1)] / (float)(h * h);
+                }
+                saw[k][i] = -(2.0f / PI) * sSaw;               // rising ramp −1 → 1
+                tri[k][i] = -(8.0f / (PI * PI)) * sTri;        // −1 at phase 0, +1 at 0.5
+            }
+            saw[k][SIZE] = saw[k][0];
+            tri[k][SIZE] = tri[k][0];
+        }
+    }
+
+    // Mip level from the float exponent of freq/BASE_HZ (no log2f)
+    static int octaveFor(float freq) {
+        float r = freq * (1.0f / BASE_HZ);
+        uint32_t bits;
+        memcpy(&bits, &r, sizeof(bits));
+        int e = (int)((bits >> 23) & 0xff) - 127;
+        return e < 0 ? 0 : (e >= OCTAVES ? OCTAVES - 1 : e);
+    }
+
+    static float lookup(const float* t, float phase) {
+        float x = phase * SIZE;
+        int   i = (int)x;
+        float f = x - (float)i;
+        i &= SIZE - 1;
+        return t[i] + f * (t[i + 1] - t[i]);
+    }
+};
+
+// ─── Oscillator ──────────────────────────────────────────────────────────────
+
+struct Oscillator {
+    float phase = 0.0f;
+    float freq  = 440.0f;
+    float pulseWidth = 0.5f;
+    float pwmPhase = 0.0f;
+    float pwmRatio = 1.0f;
+    const Wavetables* wt = nullptr;   // non-null: wavetable engine instead of PolyBLEP
+
+    void advance() {
+        phase += freq * g_invSR;
+        if (phase >= 1.0f) phase -= 1.0f;
+        pwmPhase += freq * pwmRatio * g_invSR;
+        if (pwmPhase >= 1.0f) pwmPhase -= floorf(pwmPhase);
+    }
+
+    float saw() const {
+        float dt = freq * g_invSR;
+        float s = 2.0f * phase - 1.0f;
+        s -= polyblep(phase, dt);
+        return s;
+    }
+
+    float pulse() const {
+        float dt = freq * g_invSR;
+        float s = (phase < pulseWidth) ? 1.0f : -1.0f;
+        s += polyblep(phase, dt);          // rising edge at phase=0
+        float shifted = phase - pulseWidth;
+        if (shifted < 0.0f) shifted += 1.0f;
+        s -= polyblep(shifted, dt);        // falling edge at phase=pw
+        return s;
+    }
+
+    float triangle() const {
+        return (phase < 0.5f) ? (4.0f * phase - 1.0f) : (3.0f - 4.0f * phase);
+    }
+
+    float ratioPulse() const {
+        float pw = 0.5f + 0.4f * dsp_sin(TWO_PI * pwmPhase);
+        float dt = freq * g_invSR;
+        float s = (phase < pw) ? 1.0f : -1.0f;
+        s += polyblep(phase, dt);
+        float shifted = phase - pw;
+        if (shifted < 0.0f) shifted += 1.0f;
+        s -= polyblep(shifted, dt);
+        return s;
+    }
+
+    float waveform(int idx) const {
+        if (wt) return tableWaveform(idx);
+        switch (idx) {
+        case 0: return saw();
+        case 1: return pulse();
+        case 2: return triangle();
+        case 3: return ratioPulse();
+        default: return saw();
+        }
+    }
+
+    // ── Wavetable engine (same waveform set, table lookups instead of BLEPs) ──
+
+    float tablePulse(const float* sawT, float pw) const {
+        float shifted = phase - pw;
+        if (shifted < 0.0f) shifted += 1.0f;
+        return Wavetables::lookup(sawT, shifted) - Wavetables::lookup(sawT, phase)
+             + 2.0f * pw - 1.0f;
+    }
+
+    float tableWaveform(int idx) const {
+        int k = Wavetables::octaveFor(freq);
+        switch (idx) {
+        case 1: return tablePulse(wt->saw[k], pulseWidth);
+        case 2: return Wavetables::lookup(wt->tri[k], phase);
+        case 3: return tablePulse(wt->saw[k],
+                                  0.5f + 0.4f * Wavetables::lookup(wt->sine, pwmPhase));
+        default: return Wavetables::lookup(wt->saw[k], phase);
+        }
+    }
+
+    // Compile-time waveform selection for the block kernels below
+    template <bool Table, int W>
+    float waveT() const {
+        if (Table) {
+            int k = Wavetables::octaveFor(freq);
+            if (W == 1) return tablePulse(wt->saw[k], pulseWidth);
+            if (W == 2) return Wavetables::lookup(wt->tri[k], phase);
+            if (W == 3) return tablePulse(wt->saw[k],
+                                          0.5f + 0.4f * Wavetables::lookup(wt->sine, pwmPhase));
+            return Wavetables::lookup(wt->saw[k], phase);
+        }
+        if (W == 1) return pulse();
+        if (W == 2) return triangle();
+        if (W == 3) return ratioPulse();
+        return saw();
+    }
+
+    // Block render: per-sample frequency, pulse width and morph position
+    // (crossfade between adjacent waveforms when morph is fractional).
+    // The waveform pair is a template parameter, so the kernel is picked
+    // once per block (or per run of constant floor(morph) while a morph is
+    // in flight) and a steady waveform renders with no per-sample switch.
+    void process(float* buf, const float* freqs, const float* pws,
+                 const float* morph, int n) {
+        PROBE(PROBE_OSC);
+        if (n <= 0) return;
+        const Kernel* table = wt ? kernels<true>() : kernels<false>();
+
+        // Voice's morph is a one-pole glide with a snap, so it is monotonic
+        // within a block: equal ends mean a static waveform throughout
+        if (morph[0] == morph[n - 1]) {
+            int   lo   = (int)floorf(morph[0]);
+            float frac = morph[0] - (float)lo;
+            int   idx  = ((lo % NUM_WAVEFORMS) + NUM_WAVEFORMS) % NUM_WAVEFORMS;
+            if (frac < 0.001f) {
+                (this->*table[idx * 2])(buf, freqs, pws, morph, 0.0f, n);
+                return;
+            }
+        }
+        for (int i = 0; i < n; ) {
+            int   lo  = (int)floorf(morph[i]);
+            float loF = (float)lo;
+            int   j   = i + 1;
+            while (j < n && morph[j] >= loF && morph[j] < loF + 1.0f) j++;
+            int idx = ((lo % NUM_WAVEFORMS) + NUM_WAVEFORMS) % NUM_WAVEFORMS;
+            (this->*table[idx * 2 + 1])(buf + i, freqs + i, pws + i, morph + i, loF, j - i);
+            i = j;
+        }
+    }
+
+    typedef void (Oscillator::*Kernel)(float*, const float*, const float*,
+                                       const float*, float, int);
+
+    // Lo = waveform below the morph position, Hi = the next one up.
+    // Static kernels ignore morph; morphing ones crossfade by morph - loF
+    // (a fraction under 0.001 selects Lo alone, as a select, not a branch).
+    template <bool Table, int Lo, bool Morphing>
+    void kernel(float* buf, const float* freqs, const float* pws,
+                const float* morph, float loF, int n) {
+        const int Hi = (Lo + 1) % NUM_WAVEFORMS;
+        for (int i = 0; i < n; i++) {
+            freq = freqs[i];
+            pulseWidth = pws[i];
+            advance();
+            if (!Morphing) {
+                buf[i] = waveT<Table, Lo>();
+            } else {
+                float frac = morph[i] - loF;
+                float a = waveT<Table, Lo>(), b = waveT<Table, Hi>();
+                buf[i] = frac < 0.001f ? a : a * (1.0f - frac) + b * frac;
+            }
+        }
+    }
+
+    static_assert(NUM_WAVEFORMS == 4, "kernel table below lists four waveforms");
+
+    // [waveform * 2 + morphing]; Hi is always Lo + 1, so the (lo, hi) pair
+    // table collapses to one row per waveform
+    template <bool Table>
+    static const Kernel* kernels() {
+        static const Kernel k[NUM_WAVEFORMS * 2] = {
+            &Oscillator::kernel<Table, 0, false>, &Oscillator::kernel<Table, 0, true>,
+            &Oscillator::kernel<Table, 1, false>, &Oscillator::kernel<Table, 1, true>,
+            &Oscillator::kernel<Table, 2, false>, &Oscillator::kernel<Table, 2, true>,
+            &Oscillator::kernel<Table, 3, false>, &Oscillator::kernel<Table, 3, true>,
+        };
+        return k;
+    }
+};
+
+// ─── Unison oscillator (up to 8 detuned copies, one v4f lane per copy) ─────
+// Supersaw-style stack for the mono voice. Phase, dt and the BLEP
+// corrections of four copies are one vector op (v4f_blep_wave, as in the
+// poly pool), so a group of four costs about one scalar oscillator. Copies
+// alternate left/right and are summed to mid and side; Synth feeds
+// mid ± side into the reverb's stereo input. Always PolyBLEP.
+
+static constexpr int   UNISON_MAX    = 8;
+static constexpr float UNISON_DETUNE = 20.0f;   // default stack width, ± cents
+static constexpr float UNISON_SPREAD = 0.8f;    // default side weight of the outer copies
+
+struct UnisonOsc {
+    alignas(16) float phase[UNISON_MAX]    = {};
+    alignas(16) float pwmPhase[UNISON_MAX] = {};
+    alignas(16) float ratio[UNISON_MAX]    = {};   // 2^(detune / 1200)
+    alignas(16) float weight[UNISON_MAX]   = {};   // 1 per live copy, 0 for padding lanes
+    alignas(16) float pan[UNISON_MAX]      = {};   // side weight, ±spread
+    int   copies = 0;          // 0 = off
+    int   groups = 0;          // v4f groups in use
+    float gain   = 1.0f;       // 1/√copies: the detuned sum keeps the single-osc RMS
+
+    // 2..8 copies, detuned evenly across ±cents. Outer copies pan widest and
+    // sides alternate, so each channel gets both flat and sharp copies.
+    void init(int n, float cents, float spread) {
+        copies = n < 2 ? 0 : (n > UNISON_MAX ? UNISON_MAX : n);
+        groups = (copies + 3) / 4;
+        gain   = copies ? 1.0f / sqrtf((float)copies) : 1.0f;
+        for (int c = 0; c < UNISON_MAX; c++) {
+            bool live = c < copies;
+            float p = live ? 2.0f * c / (copies - 1) - 1.0f : 0.0f;   // -1..1
+            ratio[c]  = exp2f(cents * p / 1200.0f);
+            weight[c] = live ? 1.0f : 0.0f;
+            pan[c]    = spread * fabsf(p) * ((c & 1) ? 1.0f : -1.0f);
+            // Golden-ratio start phases: no coherent spike at the first edge
+            float ph = 0.618034f * c;
+            phase[c] = pwmPhase[c] = ph - floorf(ph);
+        }
+    }
+
+    void process(float* mid, float* side, const float* freqs, const float* pws,
+                 const float* morph, float pwmRatio, int n) {
+        PROBE(PROBE_OSC);
+        if (n <= 0) return;
+        if (groups > 1) kernel<2>(mid, side, freqs, pws, morph, pwmRatio, n);
+        else            kernel<1>(mid, side, freqs, pws, morph, pwmRatio, n);
+    }
+
+    // Per sample: advance every copy, BLEP the waveform (crossfaded while
+    // morphing), sum to mid/side. dt and 1/dt follow the glide only.
+    template <int G>
+    void kernel(float* mid, float* side, const float* freqs, const float* pws,
+                const float* morph, float pwmRatio, int n) {
+        const v4f one = v4f_set1(1.0f);
+        v4f ph[G], pwmPh[G], rt[G], w[G], pn[G], dt[G], invDt[G];
+        for (int g = 0; g < G; g++) {
+            ph[g]    = *(const v4f*)&phase[g * 4];
+            pwmPh[g] = *(const v4f*)&pwmPhase[g * 4];
+            rt[g]    = *(const v4f*)&ratio[g * 4];
+            w[g]     = *(const v4f*)&weight[g * 4];
+            pn[g]    = *(const v4f*)&pan[g * 4];
+        }
+        float lastFreq = freqs[0];
+        for (int g = 0; g < G; g++) {
+            dt[g] = rt[g] * (lastFreq * g_invSR);
+            invDt[g] = one / dt[g];
+        }
+        for (int i = 0; i < n; i++) {
+            if (freqs[i] != lastFreq) {
+                lastFreq = freqs[i];
+                for (int g = 0; g < G; g++) {
+                    dt[g] = rt[g] * (lastFreq * g_invSR);
+                    invDt[g] = one / dt[g];
+                }
+            }
+            int lo = (int)floorf(morph[i]);
+            float frac = morph[i] - (float)lo;
+            int loIdx = ((lo % NUM_WAVEFORMS) + NUM_WAVEFORMS) % NUM_WAVEFORMS;
+            int hiIdx = (loIdx + 1) % NUM_WAVEFORMS;
+
+            v4f m = v4f_set1(0.0f), s = v4f_set1(0.0f);
+            for (int g = 0; g < G; g++) {
+                ph[g] += dt[g];
+                ph[g] = v4f_select(ph[g] >= one, ph[g] - one, ph[g]);
+                pwmPh[g] = v4f_wrap_phase(pwmPh[g] + dt[g] * pwmRatio);   // ratio up to 8x: may pass 2
+                v4f x = v4f_blep_wave(loIdx, ph[g], pwmPh[g], dt[g], invDt[g], pws[i]);
+                if (frac >= 0.001f)
+                    x = x * (1.0f - frac)
+                      + v4f_blep_wave(hiIdx, ph[g], pwmPh[g], dt[g], invDt[g], pws[i]) * frac;
+                m += x * w[g];
+                s += x * pn[g];
+            }
+            mid[i]  = ((m[0] + m[1]) + (m[2] + m[3])) * gain;
+            side[i] = ((s[0] + s[1]) + (s[2] + s[3])) * gain;
+        }
+        for (int g = 0; g < G; g++) {
+            *(v4f*)&phase[g * 4]    = ph[g];
+            *(v4f*)&pwmPhase[g * 4] = pwmPh[g];
+        }
+    }
+};
+
+// ─── Portamento (one-pole in log2-freq domain) ───────────────────────────────
+
+struct Portamento {
+    float target   = 0.0f;   // log2(freq)
+    float current  = 0.0f;   // log2(freq)
+    float coeff    = 1.0f;   // 1.0 = instant
+    float cachedLog  = NAN;  // exp2 cache: skips the call once the glide settles
+    float cachedFreq = 0.0f;
+
+    static float coeffForMs(float ms) {
+        if (ms < 1.0f) return 1.0f;
+        float samples = ms * 0.001f * g_sampleRate;
+        return 1.0f - expf(-1.0f / samples);
+    }
+
+    void setTime(float ms) { coeff = coeffForMs(ms); }
+
+    void setTarget(float freqHz) {
+        target = log2f(freqHz);
+    }
+
+    void snap(float freqHz) {
+        target  = log2f(freqHz);
+        current = target;
+    }
+
+    float tick() {
+        current += coeff * (target - current);
+        if (current != cachedLog) {
+            cachedLog  = current;
+            cachedFreq = dsp_exp2(current);
+        }
+        return cachedFreq;
+    }
+
+    // Block render: writes per-sample frequency (Hz)
+    void process(float* buf, int n) {
+        for (int i = 0; i < n; i++) buf[i] = tick();
+    }
+};
+
+// ─── Triangle LFO (for PWM modulation, tied to portamento time) ─────────────
+
+struct TriLFO {
+    float phase = 0.0f;
+    float freq  = 0.0f;
+
+    static float freqForPeriodMs(float ms) {
+        return (ms < 1.0f) ? 0.0f : 1000.0f / ms;
+    }
+
+    void setPeriodMs(float ms) { freq = freqForPeriodMs(ms); }
+
+    float tick() {
+        if (freq <= 0.0f) return 0.0f;
+        phase += freq * g_invSR;
+        if (phase >= 1.0f) phase -= 1.0f;
+        return (phase < 0.5f) ? (4.0f * phase - 1.0f) : (3.0f - 4.0f * phase);
+    }
+
+    void process(float* buf, int n) {
+        for (int i = 0; i < n; i++) buf[i] = tick();
+    }
+};
+
+// ─── Cytomic SVF (trapezoidal integration, unconditionally stable) ───────────
+
+struct SVFilter {
+    float ic1eq = 0.0f;
+    float ic2eq = 0.0f;
+    float g     = 0.0f;
+    float k     = 2.0f;   // k = 2 - 2*reso
+    float a1    = 0.0f;
+    float a2    = 0.0f;
+    float a3    = 0.0f;
+    float lastCutoff = NAN;   // coefficient cache: setParams is a no-op when unchanged
+    float lastReso   = NAN;
+    float lastRate   = 0.0f;  // ...at the same sample rate
+
+    // a1..a3 are the coefficients for these parameters at the current rate
+    bool holds(float cutoffHz, float reso) const {
+        return cutoffHz == lastCutoff && reso == lastReso && lastRate == g_sampleRate;
+    }
+
+    void setParams(float cutoffHz, float reso) {
+        if (holds(cutoffHz, reso)) return;
+        lastCutoff = cutoffHz;
+        lastReso   = reso;
+        lastRate   = g_sampleRate;
+        float fc = cutoffHz;
+        // Ceiling stays below Nyquist at low granted rates (tan → ∞ at fs/2)
+        float fcMax = 0.45f * g_sampleRate;
+        if (fcMax > 20000.0f) fcMax = 20000.0f;
+        if (fc < 20.0f)  fc = 20.0f;
+        if (fc > fcMax)  fc = fcMax;
+        g  = dsp_tan(PI * fc * g_invSR);
+        k  = 2.0f - 2.0f * reso;
+        a1 = 1.0f / (1.0f + g * (g + k));
+        a2 = g * a1;
+        a3 = g * a2;
+    }
+
+    // Returns low-pass output
+    float tick(float v0) {
+        float v3 = v0 - ic2eq;
+        float v1 = a1 * ic1eq + a2 * v3;
+        float v2 = ic2eq + a2 * ic1eq + a3 * v3;
+        ic1eq = 2.0f * v1 - ic1eq;
+        ic2eq = 2.0f * v2 - ic2eq;
+        return v2;
+    }
+
+    // In-place block filter with the current coefficients
+    void process(float* buf, int n) {
+        PROBE(PROBE_FILTER);
+        float s1 = ic1eq, s2 = ic2eq;
+        for (int i = 0; i < n; i++) {
+            float v3 = buf[i] - s2;
+            float v1 = a1 * s1 + a2 * v3;
+            float v2 = s2 + a2 * s1 + a3 * v3;
+            s1 = 2.0f * v1 - s1;
+            s2 = 2.0f * v2 - s2;
+            buf[i] = v2;
+        }
+        ic1eq = flush_denormal(s1);
+        ic2eq = flush_denormal(s2);
+    }
+
+    // In-place block filter with per-sample coefficients (k-rate ramps)
+    void process(float* buf, const float* a1s, const float* a2s, const float* a3s, int n) {
+        PROBE(PROBE_FILTER);
+        float s1 = ic1eq, s2 = ic2eq;
+        for (int i = 0; i < n; i++) {
+            float v3 = buf[i] - s2;
+            float v1 = a1s[i] * s1 + a2s[i] * v3;
+            float v2 = s2 + a2s[i] * s1 + a3s[i] * v3;
+            s1 = 2.0f * v1 - s1;
+            s2 = 2.0f * v2 - s2;
+            buf[i] = v2;
+        }
+        ic1eq = flush_denormal(s1);
+        ic2eq = flush_denormal(s2);
+    }
+};
+
+// ─── AR Envelope ─────────────────────────────────────────────────────────────
+
+struct Envelope {
+    enum Stage { OFF, ATTACK, RELEASE };
+    Stage stage       = OFF;
+    float value       = 0.0f;
+    float attackCoeff = 0.0f;
+    float releaseCoeff= 0.0f;
+
+    Envelope() {
+        setAttack(ATTACK_MS);
+        setRelease(200.0f);
+    }
+
+    void setAttack(float ms) {
+        float samples = ms * 0.001f * g_sampleRate;
+        attackCoeff = 1.0f - expf(-1.0f / samples);
+    }
+
+    static float releaseCoeffForMs(float ms) {
+        if (ms < 1.0f) ms = 1.0f;
+        float samples = ms * 0.001f * g_sampleRate;
+        return expf(-1.0f / samples);
+    }
+
+    void setRelease(float ms) { releaseCoeff = releaseCoeffForMs(ms); }
+
+    void gate(bool on) {
+        if (on) stage = ATTACK;
+        else if (stage == ATTACK) stage = RELEASE;
+    }
+
+    float tick() {
+        switch (stage) {
+        case ATTACK:
+            value += attackCoeff * (1.0f - value);
+            if (value > 0.999f) { value = 1.0f; }
+            break;
+        case RELEASE:
+            value *= releaseCoeff;
+            if (value < 0.0001f) { value = 0.0f; stage = OFF; }
+            break;
+        case OFF:
+            break;
+        }
+        return value;
+    }
+
+    // Apply envelope gain to a block in place
+    void process(float* buf, int n) {
+        for (int i = 0; i < n; i++) buf[i] *= tick();
+    }
+};
+
+// ─── Note Stack (last-note priority) ─────────────────────────────────────────
+
+struct NoteStack {
+    int notes[NOTE_STACK_SZ];
+    int size = 0;
+
+    void push(int note) {
+        // Remove if already present
+        remove(note);
+        if (size < NOTE_STACK_SZ) {
+            notes[size++] = note;
+        }
+    }
+
+    void remove(int note) {
+        for (int i = 0; i < size; i++) {
+            if (notes[i] == note) {
+                for (int j = i; j < size - 1; j++)
+                    notes[j] = notes[j + 1];
+                size--;
+                return;
+            }
+        }
+    }
+
+    int top() const { return size > 0 ? notes[size - 1] : -1; }
+    bool empty() const { return size == 0; }
+};
+
+// ─── Note Tracker (speed/length dynamics from play style) ───────────────────
+
+struct NoteTracker {
+    uint64_t sampleCounter    = 0;
+    uint64_t lastNoteOnSample = 0;
+    float    avgIntervalSamples = g_sampleRate;  // 1 second default
+    float    speed            = 0.0f;        // 0=slow, 1=fast
+    float    length           = 0.0f;        // 0=short, 1=long
+
+    // Ring buffer of last 3 note durations
+    float    durations[3]     = {g_sampleRate, g_sampleRate, g_sampleRate};
+    int      durIdx           = 0;
+    float    avgDuration      = g_sampleRate;
+
+    // One-pole smoothing (~2.3s time constant)
+    const float SMOOTH = 1e-5f * (SAMPLE_RATE / g_sampleRate);
+
+    // Thresholds in samples
+    const float FAST_INTERVAL  = 0.05f * g_sampleRate;   // 50ms
+    const float SLOW_INTERVAL  = 1.0f  * g_sampleRate;   // 1000ms
+    const float SHORT_DUR      = 0.05f * g_sampleRate;   // 50ms
+    const float LONG_DUR       = 2.0f  * g_sampleRate;   // 2000ms
+
+    void noteOn() {
+        uint64_t now = sampleCounter;
+        uint64_t interval = now - lastNoteOnSample;
+        lastNoteOnSample = now;
+        // Smooth the interval (exponential moving average)
+        if (interval < (uint64_t)(SLOW_INTERVAL * 4))  // ignore huge gaps
+            avgIntervalSamples += 0.3f * ((float)interval - avgIntervalSamples);
+    }
+
+    void noteOff() {
+        uint64_t dur = sampleCounter - lastNoteOnSample;
+        durations[durIdx] = (float)dur;
+        durIdx = (durIdx + 1) % 3;
+        avgDuration = (durations[0] + durations[1] + durations[2]) / 3.0f;
+    }
+
+    void tick() {
+        sampleCounter++;
+
+        // Map interval → speed: fast (small interval) = 1, slow = 0
+        float rawSpeed = 1.0f - (avgIntervalSamples - FAST_INTERVAL) / (SLOW_INTERVAL - FAST_INTERVAL);
+        if (rawSpeed < 0.0f) rawSpeed = 0.0f;
+        if (rawSpeed > 1.0f) rawSpeed = 1.0f;
+        speed += SMOOTH * (rawSpeed - speed);
+
+        // Map duration → length: long = 1, short = 0
+        float rawLength = (avgDuration - SHORT_DUR) / (LONG_DUR - SHORT_DUR);
+        if (rawLength < 0.0f) rawLength = 0.0f;
+        if (rawLength > 1.0f) rawLength = 1.0f;
+        length += SMOOTH * (rawLength - length);
+    }
+
+    // Advance n samples; raw targets are constant within a block since
+    // note events are only applied at block boundaries
+    void process(int n) {
+        float rawSpeed = 1.0f - (avgIntervalSamples - FAST_INTERVAL) / (SLOW_INTERVAL - FAST_INTERVAL);
+        if (rawSpeed < 0.0f) rawSpeed = 0.0f;
+        if (rawSpeed > 1.0f) rawSpeed = 1.0f;
+        float rawLength = (avgDuration - SHORT_DUR) / (LONG_DUR - SHORT_DUR);
+        if (rawLength < 0.0f) rawLength = 0.0f;
+        if (rawLength > 1.0f) rawLength = 1.0f;
+        for (int i = 0; i < n; i++) {
+            speed  += SMOOTH * (rawSpeed - speed);
+            length += SMOOTH * (rawLength - length);
+        }
+        speed  = flush_denormal(speed);
+        length = flush_denormal(length);
+        sampleCounter += n;
+    }
+
+    // Idle variant: the same n one-pole steps in closed form (one powf
+    // instead of a 2n-long dependency chain; agrees to float rounding)
+    void coast(int n) {
+        float rawSpeed = 1.0f - (avgIntervalSamples - FAST_INTERVAL) / (SLOW_INTERVAL - FAST_INTERVAL);
+        if (rawSpeed < 0.0f) rawSpeed = 0.0f;
+        if (rawSpeed > 1.0f) rawSpeed = 1.0f;
+        float rawLength = (avgDuration - SHORT_DUR) / (LONG_DUR - SHORT_DUR);
+        if (rawLength < 0.0f) rawLength = 0.0f;
+        if (rawLength > 1.0f) rawLength = 1.0f;
+        float d = powf(1.0f - SMOOTH, (float)n);
+        speed  = rawSpeed  + (speed  - rawSpeed)  * d;
+        length = flush_denormal(rawLength + (length - rawLength) * d);
+        speed  = flush_denormal(speed);
+        sampleCounter += n;
+    }
+};
+
+// ─── Polyphase IIR half-band (2× resampling as two allpass chains) ─────────
+// Elliptic half-band split into two allpass paths, run at the low rate:
+// even coefficients form path 0, odd ones path 1; each stage is
+// y = a·(x − y₁) + x₁. Non-linear phase, a handful of multiplies per sample.
+
+// 1× ↔ 2×: passband to 0.45·fs (19.8 kHz), 80 dB stopband
+static const float HALFBAND_2X[6] = {
+    0.060297391f, 0.215971445f, 0.412590720f, 0.604358626f, 0.772715654f, 0.923886139f
+};
+// 2× ↔ 4×: the 2× stream is already band-limited, so a wide transition will do (89 dB)
+static const float HALFBAND_4X[3] = {0.070224059f, 0.285086280f, 0.684541359f};
+
+template <int NC>
+struct HalfBand {
+    float coef[NC];
+    float x[NC] = {};
+    float y[NC] = {};
+
+    void init(const float* c) {
+        for (int i = 0; i < NC; i++) coef[i] = c[i];
+        reset();
+    }
+
+    void reset() {
+        for (int i = 0; i < NC; i++) x[i] = y[i] = 0.0f;
+    }
+
+    // One low-rate step of both paths on local copies of the state (kept in
+    // registers across a block)
+    static void step(float& p0, float& p1, const float* c, float* xs, float* ys) {
+        for (int i = 0; i < NC; i += 2) {
+            float t = (p0 - ys[i]) * c[i] + xs[i];
+            xs[i] = p0; ys[i] = t; p0 = t;
+            if (i + 1 < NC) {
+                float u = (p1 - ys[i + 1]) * c[i + 1] + xs[i + 1];
+                xs[i + 1] = p1; ys[i + 1] = u; p1 = u;
+            }
+        }
+    }
+
+    // n samples → 2n (unity gain)
+    void up(const float* in, float* out, int n) {
+        float c[NC], xs[NC], ys[NC];
+        for (int i = 0; i < NC; i++) { c[i] = coef[i]; xs[i] = x[i]; ys[i] = y[i]; }
+        for (int i = 0; i < n; i++) {
+            float p0 = in[i], p1 = in[i];
+            step(p0, p1, c, xs, ys);
+            out[2 * i]     = p0;
+            out[2 * i + 1] = p1;
+        }
+        for (int i = 0; i < NC; i++) { x[i] = flush_denormal(xs[i]); y[i] = flush_denormal(ys[i]); }
+    }
+
+    // 2n samples → n
+    void down(const float* in, float* out, int n) {
+        float c[NC], xs[NC], ys[NC];
+        for (int i = 0; i < NC; i++) { c[i] = coef[i]; xs[i] = x[i]; ys[i] = y[i]; }
+        for (int i = 0; i < n; i++) {
+            float p0 = in[2 * i + 1], p1 = in[2 * i];
+            step(p0, p1, c, xs, ys);
+            out[i] = 0.5f * (p0 + p1);
+        }
+        for (int i = 0; i < NC; i++) { x[i] = flush_denormal(xs[i]); y[i] = flush_denormal(ys[i]); }
+    }
+};
+
+// ─── Distortion (tanh waveshaper) ───────────────────────────────────────────
+
+struct Distortion {
+    float drive  = 1.0f;
+    float dryWet = 0.0f;
+    float amount = 0.0f;
+    // Control-rate cache: only change when amount does
+    float preGain  = 1.0f;                 // (1 + amount/2) · drive
+    float invNorm  = 1.0f / tanhf(1.0f);   // 1 / tanh(drive)
+
+    // Optional oversampling: above OS_ON the shaper runs at 2×/4× between
+    // half-band filters (below it the drive is too low to alias audibly).
+    // Engaging/disengaging crossfades over one block; the filters restart
+    // from silence on each engage.
+    static constexpr float OS_ON  = 0.25f;
+    static constexpr float OS_OFF = 0.20f;   // hysteresis
+    int   osFactor = 1;        // 1 = off, 2 or 4
+    bool  osActive = false;
+    float osMix    = 0.0f;     // 0 = base rate, 1 = oversampled
+    HalfBand<6> up2, down2;    // 1× ↔ 2×
+    HalfBand<3> up4, down4;    // 2× ↔ 4×
+
+    void setOversample(int factor) {
+        osFactor = (factor >= 4) ? 4 : (factor >= 2 ? 2 : 1);
+        up2.init(HALFBAND_2X); down2.init(HALFBAND_2X);
+        up4.init(HALFBAND_4X); down4.init(HALFBAND_4X);
+    }
+
+    void updateFromDynamics(float speed, float releaseNorm) {
+        float a = speed * (0.3f + 0.7f * (1.0f - releaseNorm));
+        if (a == amount) return;
+        amount  = a;
+        drive   = 1.0f + amount * 15.0f;
+        dryWet  = amount;
+        preGain = (1.0f + amount * 0.5f) * drive;
+        invNorm = 1.0f / dsp_tanh(drive);
+    }
+
+    float process(float in) {
+        float wet = dsp_tanh(in * preGain) * invNorm;
+        return in + dryWet * (wet - in);
+    }
+
+    void process(float* buf, int n) {
+        PROBE(PROBE_DIST);
+        if (osFactor > 1) {
+            bool want = amount > (osActive ? OS_OFF : OS_ON);
+            if (want && !osActive) {
+                up2.reset(); down2.reset();
+                up4.reset(); down4.reset();
+            }
+            osActive = want;
+        }
+        float target = osActive ? 1.0f : 0.0f;
+        if (osMix == 0.0f && target == 0.0f) {
+            for (int i = 0; i < n; i++) buf[i] = process(buf[i]);
+            return;
+        }
+
+        float os[BLOCK_FRAMES];
+        processOversampled(buf, os, n);
+        if (osMix == 1.0f && target == 1.0f) {
+            for (int i = 0; i < n; i++) buf[i] = os[i];
+            return;
+        }
+        float step = (target - osMix) / (float)n;
+        for (int i = 0; i < n; i++) {
+            osMix += step;
+            float b = process(buf[i]);
+            buf[i] = b + osMix * (os[i] - b);
+        }
+        osMix = target;
+    }
+
+private:
+    // Shaper (including the dry/wet mix, so dry and wet share the filters'
+    // phase response) at osFactor × the sample rate
+    void processOversampled(const float* in, float* out, int n) {
+        float x2[2 * BLOCK_FRAMES];
+        up2.up(in, x2, n);
+        if (osFactor == 4) {
+            float x4[4 * BLOCK_FRAMES];
+            up4.up(x2, x4, 2 * n);
+            for (int i = 0; i < 4 * n; i++) x4[i] = process(x4[i]);
+            down4.down(x4, x2, 2 * n);
+        } else {
+            for (int i = 0; i < 2 * n; i++) x2[i] = process(x2[i]);
+        }
+        down2.down(x2, out, n);
+    }
+};
+
+// ─── LP-Comb filter (for Schroeder reverb) ──────────────────────────────────
+
+struct LPComb {
+    float* buf     = nullptr;   // size floats carved from the owning Reverb's arena
+    int    size    = 0;
+    int    idx     = 0;
+    float  feedback = 0.0f;
+    float  lpState = 0.0f;
+    float  lpCoeff = 0.45f;
+
+    void clear() {
+        memset(buf, 0, size * sizeof(float));
+        lpState = 0.0f;
+    }
+
+    void init(float* mem, int delaySamples, float fb) {
+        buf  = mem;
+        size = delaySamples;
+        feedback = fb;
+        idx = 0;
+        lpState = 0.0f;
+        memset(buf, 0, size * sizeof(float));
+    }
+
+    float process(float in) {
+        float out = buf[idx];
+        // One-pole LPF in feedback path (dark/warm character)
+        lpState = out + lpCoeff * (lpState - out);
+        buf[idx] = in + lpState * feedback;
+        idx++;
+        if (idx >= size) idx = 0;
+        return out;
+    }
+
+    // Block render: adds comb output to acc (parallel comb bank summing)
+    void process(const float* in, float* acc, int n) {
+        float lp = lpState;
+        int   j  = idx;
+        for (int i = 0; i < n; i++) {
+            float out = buf[j];
+            lp = out + lpCoeff * (lp - out);
+            buf[j] = in[i] + lp * feedback;
+            if (++j >= size) j = 0;
+            acc[i] += out;
+        }
+        lpState = flush_denormal(lp);
+        idx = j;
+    }
+};
+
+// ─── Allpass filter (diffusion) ─────────────────────────────────────────────
+
+struct Allpass {
+    float* buf  = nullptr;   // size floats carved from the owning Reverb's arena
+    int    size = 0;
+    int    idx  = 0;
+    float  gain = 0.5f;
+
+    void clear() { memset(buf, 0, size * sizeof(float)); }
+
+    void init(float* mem, int delaySamples, float g) {
+        buf  = mem;
+        size = delaySamples;
+        gain = g;
+        idx = 0;
+        memset(buf, 0, size * sizeof(float));
+    }
+
+    float process(float in) {
+        float delayed = buf[idx];
+        float out = -in + delayed;
+        buf[idx] = in + delayed * gain;
+        idx++;
+        if (idx >= size) idx = 0;
+        return out;
+    }
+
+    // In-place block diffusion
+    void process(float* io, int n) {
+        int j = idx;
+        for (int i = 0; i < n; i++) {
+            float delayed = buf[j];
+            float in = io[i];
+            io[i] = -in + delayed;
+            buf[j] = in + delayed * gain;
+            if (++j >= size) j = 0;
+        }
+        idx = j;
+    }
+};
+
+// ─── LP-comb bank (8 combs as two 4-lane vectors: L = 0..3, R = 4..7) ──────
+
+struct CombBank {
+    static constexpr int LANES = 8;
+    // Structure-of-arrays state; delay lines stay in the bound LPCombs
+    alignas(16) float lpState[LANES];
+    alignas(16) float feedback[LANES];
+    alignas(16) float lpCoeff[LANES];
+    float* line[LANES];
+    int    size[LANES];
+    int    idx[LANES];
+
+    void bind(LPComb* combL, LPComb* combR) {
+        for (int c = 0; c < LANES; c++) {
+            LPComb& src = (c < 4) ? combL[c] : combR[c - 4];
+            lpState[c]  = src.lpState;
+            feedback[c] = src.feedback;
+            lpCoeff[c]  = src.lpCoeff;
+            line[c]     = src.buf;
+            size[c]     = src.size;
+            idx[c]      = src.idx;
+        }
+    }
+
+    // Writes 0.25 * (sum of 4 combs) per channel for the block; L lanes take
+    // inL, R lanes inR (the same buffer for a mono source)
+    void process(const float* inL, const float* inR, float* sumL, float* sumR, int n) {
+        v4f lpL = *(const v4f*)&lpState[0], lpR = *(const v4f*)&lpState[4];
+        const v4f fbL = *(const v4f*)&feedback[0], fbR = *(const v4f*)&feedback[4];
+        const v4f cL  = *(const v4f*)&lpCoeff[0],  cR  = *(const v4f*)&lpCoeff[4];
+        float* l0 = line[0]; float* l1 = line[1]; float* l2 = line[2]; float* l3 = line[3];
+        float* r0 = line[4]; float* r1 = line[5]; float* r2 = line[6]; float* r3 = line[7];
+
+        int i = 0;
+        while (i < n) {
+            // Run until the first lane wraps; delays (> 1700) exceed the block,
+            // so reads never see this chunk's writes
+            int m = n - i;
+            for (int c = 0; c < LANES; c++)
+                if (size[c] - idx[c] < m) m = size[c] - idx[c];
+
+            float* pl0 = l0 + idx[0]; float* pl1 = l1 + idx[1];
+            float* pl2 = l2 + idx[2]; float* pl3 = l3 + idx[3];
+            float* pr0 = r0 + idx[4]; float* pr1 = r1 + idx[5];
+            float* pr2 = r2 + idx[6]; float* pr3 = r3 + idx[7];
+            for (int t = 0; t < m; t++) {
+                v4f oL = v4f{pl0[t], pl1[t], pl2[t], pl3[t]};
+                v4f oR = v4f{pr0[t], pr1[t], pr2[t], pr3[t]};
+                lpL = oL + cL * (lpL - oL);
+                lpR = oR + cR * (lpR - oR);
+                v4f wL = v4f_set1(inL[i + t]) + lpL * fbL;
+                v4f wR = v4f_set1(inR[i + t]) + lpR * fbR;
+                pl0[t] = wL[0]; pl1[t] = wL[1]; pl2[t] = wL[2]; pl3[t] = wL[3];
+                pr0[t] = wR[0]; pr1[t] = wR[1]; pr2[t] = wR[2]; pr3[t] = wR[3];
+                // Same summation order as the scalar comb loop
+                sumL[i + t] = (((oL[0] + oL[1]) + oL[2]) + oL[3]) * 0.25f;
+                sumR[i + t] = (((oR[0] + oR[1]) + oR[2]) + oR[3]) * 0.25f;
+            }
+            for (int c = 0; c < LANES; c++) {
+                idx[c] += m;
+                if (idx[c] >= size[c]) idx[c] = 0;
+            }
+            i += m;
+        }
+        *(v4f*)&lpState[0] = flush_denormal(lpL);
+        *(v4f*)&lpState[4] = flush_denormal(lpR);
+    }
+};
+
+// ─── Stereo Reverb (Schroeder, SP404-inspired) ─────────────────────────────
+// The comb and allpass lines are sized from the granted rate and packed back
+// to back in one arena, so the working set is just the delay memory in use
+// (~67 KB at 44.1 kHz) in contiguous pages rather than 12 fixed buffers.
+
+// Sum of the comb and allpass delays below, in samples at 44.1 kHz
+static constexpr int REVERB_DELAYS_44K = (1764 + 1887 + 2023 + 2197) + (1789 + 1913 + 2053 + 2232)
+                                       + (307 + 113) + (331 + 127);
+
+struct Reverb {
+    // Every line at MAX_SAMPLE_RATE, plus one sample of rounding per line
+    static constexpr int ARENA =
+        (int)((long long)REVERB_DELAYS_44K * MAX_SAMPLE_RATE / SAMPLE_RATE) + 12;
+    alignas(16) float arena[ARENA];
+    int used = 0;   // arena floats in use at this rate
+
+    // 4 LP-comb filters per channel (L/R have different prime delays for stereo)
+    LPComb combL[4];
+    LPComb combR[4];
+    // 2 allpass filters per channel
+    Allpass apL[2];
+    Allpass apR[2];
+
+    CombBank bank;   // SIMD view of combL/combR (owns their state once bound)
+
+    float wet = 0.0f;
+    float amount = 0.0f;
+    float tailPeak = 0.0f;   // max |comb sum| over the last block (tail level, wet or not)
+
+    // Delay lengths below are sample counts at 44.1 kHz, scaled to the running rate
+    static int scaled(int samples44k) {
+        return (int)(samples44k * g_sampleRate / SAMPLE_RATE + 0.5f);
+    }
+
+    // Next len floats of the arena
+    float* carve(int len) {
+        float* p = arena + used;
+        used += len;
+        return p;
+    }
+    void comb(LPComb& c, int samples44k, float fb) {
+        int len = scaled(samples44k);
+        c.init(carve(len), len, fb);
+    }
+    void allpass(Allpass& a, int samples44k, float g) {
+        int len = scaled(samples44k);
+        a.init(carve(len), len, g);
+    }
+
+    void init() {
+        used = 0;
+        // Comb delay times (near-prime sample counts, ~40-50ms for larger room)
+        // L channel
+        comb(combL[0], 1764, 0.88f);  // ~40.0ms
+        comb(combL[1], 1887, 0.86f);  // ~42.8ms
+        comb(combL[2], 2023, 0.90f);  // ~45.9ms
+        comb(combL[3], 2197, 0.92f);  // ~49.8ms
+        // R channel (slightly offset for stereo width)
+        comb(combR[0], 1789, 0.88f);
+        comb(combR[1], 1913, 0.86f);
+        comb(combR[2], 2053, 0.90f);
+        comb(combR[3], 2232, 0.92f);
+
+        // Allpass diffusers (~7ms and ~2.5ms for more diffusion)
+        allpass(apL[0], 307, 0.5f);   // ~7.0ms
+        allpass(apL[1], 113, 0.5f);   // ~2.6ms
+        allpass(apR[0], 331, 0.5f);   // ~7.5ms (offset)
+        allpass(apR[1], 127, 0.5f);   // ~2.9ms (offset)
+
+        bank.bind(combL, combR);
+    }
+
+    // Zero every line and damping state (once the tail is inaudible, so the
+    // next note starts from a clean, denormal-free reverb)
+    void clear() {
+        for (int c = 0; c < 4; c++) { combL[c].clear(); combR[c].clear(); }
+        for (int a = 0; a < 2; a++) { apL[a].clear(); apR[a].clear(); }
+        for (int c = 0; c < CombBank::LANES; c++) bank.lpState[c] = 0.0f;
+    }
+
+    void updateFromDynamics(float length, float releaseNorm) {
+        amount = length * (0.5f + 0.5f * releaseNorm);
+        wet = amount * 0.85f;
+    }
+
+    void process(float in, float& outL, float& outR) {
+        // Sum of 4 parallel combs per channel
+        float sumL = 0.0f, sumR = 0.0f;
+        for (int i = 0; i < 4; i++) {
+            sumL += combL[i].process(in);
+            sumR += combR[i].process(in);
+        }
+        sumL *= 0.25f;
+        sumR *= 0.25f;
+
+        // Series allpass diffusion
+        for (int i = 0; i < 2; i++) {
+            sumL = apL[i].process(sumL);
+            sumR = apR[i].process(sumR);
+        }
+
+        // Dry/wet mix
+        outL = in + wet * (sumL - in);
+        outR = in + wet * (sumR - in);
+    }
+
+    // Block render: the comb bank runs as SIMD lanes where available, the
+    // allpasses as their own scalar loops. Stereo input feeds the L combs
+    // from inL and the R combs from inR; pass one buffer twice for mono.
+    void process(const float* inL, const float* inR, float* outL, float* outR, int n) {
+        PROBE(PROBE_REVERB);
+#if MONOSYNTH_SIMD
+        bank.process(inL, inR, outL, outR, n);
+        mix(inL, inR, outL, outR, n);
+#else
+        processScalar(inL, inR, outL, outR, n);
+#endif
+    }
+
+    // Scalar reference: each comb/allpass runs as its own loop over the block.
+    // Don't mix with process() on one instance once SIMD is on — the bank
+    // holds the live comb state.
+    void processScalar(const float* inL, const float* inR, float* outL, float* outR, int n) {
+        for (int i = 0; i < n; i++) { outL[i] = 0.0f; outR[i] = 0.0f; }
+        for (int c = 0; c < 4; c++) {
+            combL[c].process(inL, outL, n);
+            combR[c].process(inR, outR, n);
+        }
+        for (int i = 0; i < n; i++) { outL[i] *= 0.25f; outR[i] *= 0.25f; }
+        mix(inL, inR, outL, outR, n);
+    }
+
+private:
+    // Series allpass diffusion + dry/wet mix on the comb sums
+    void mix(const float* inL, const float* inR, float* outL, float* outR, int n) {
+        float pl = block_peak(outL, n), pr = block_peak(outR, n);
+        tailPeak = pl > pr ? pl : pr;
+
+        for (int a = 0; a < 2; a++) {
+            apL[a].process(outL, n);
+            apR[a].process(outR, n);
+        }
+
+        for (int i = 0; i < n; i++) {
+            outL[i] = inL[i] + wet * (outL[i] - inL[i]);
+            outR[i] = inR[i] + wet * (outR[i] - inR[i]);
+        }
+    }
+};
+
+// ─── FDN reverb (8 lines, Hadamard feedback, one power-of-two arena) ───────
+// Alternative engine to the Schroeder bank (Synth::init fdnMode). Each line
+// is a ring of nextpow2(length) floats packed back to back in one arena;
+// every line reads `length` samples behind a shared write counter, so the
+// wrap is a mask instead of a compare (32 KB of lines at 44.1 kHz, against
+// ~67 KB for the Schroeder bank). Per-pass damping and feedback gain are
+// matched to the comb bank's decay per sample, and the 8×8 Hadamard mix
+// makes every echo feed every line (~3x the bank's echo density at 50 ms).
+
+static inline int next_prime(int n) {
+    if (n < 2) return 2;
+    for (;; n++) {
+        bool prime = true;
+        for (int d = 2; d * d <= n; d++)
+            if (n % d == 0) { prime = false; break; }
+        if (prime) return n;
+    }
+}
+
+// H4 (unnormalised) on one vector: {a+b+c+d, a-b+c-d, a+b-c-d, a-b-c+d}
+static inline v4f hadamard4(v4f v) {
+    const v4f s1 = {1.0f, -1.0f, 1.0f, -1.0f}, s2 = {1.0f, 1.0f, -1.0f, -1.0f};
+    v4f t = __builtin_shuffle(v, v4i{0, 0, 2, 2}) + __builtin_shuffle(v, v4i{1, 1, 3, 3}) * s1;
+    return __builtin_shuffle(t, v4i{0, 1, 0, 1}) + __builtin_shuffle(t, v4i{2, 3, 2, 3}) * s2;
+}
+
+// Line lengths (primes) at 44.1 kHz, ~12-23 ms; rescaled lengths stay prime
+static const int FDN_LENGTHS_44K[8] = {523, 607, 691, 773, 853, 929, 983, 1019};
+
+struct FdnReverb {
+    static constexpr int LINES = 8;
+    static constexpr int ARENA = LINES * 4096;   // fits every line at MAX_SAMPLE_RATE
+
+    alignas(16) float arena[ARENA];
+    alignas(16) float lpState[LINES];
+    alignas(16) float lpCoeff[LINES];
+    alignas(16) float gain[LINES];   // per-pass feedback, includes the 1/√8 of the mix
+    alignas(16) float frame[BLOCK_FRAMES * LINES];   // block scratch, 8 lines per sample
+    int      length[LINES];
+    int      base[LINES];            // ring offset in arena
+    uint32_t mask[LINES];
+    int      used = 0;               // arena floats in use at this rate
+    uint32_t pos  = 0;               // shared write counter
+
+    float wet = 0.0f;
+    float amount = 0.0f;
+    float tailPeak = 0.0f;
+
+    // The comb bank's average loop (~1968 samples at 44.1 kHz, damping 0.45
+    // → 0.38 Nyquist gain) with the feedback of its late, longest-comb decay,
+    // scaled to each line's length. Gains match the bank's impulse energy.
+    static constexpr float REF_LEN      = 1968.0f;
+    static constexpr float REF_FEEDBACK = 0.91f;
+    static constexpr float REF_HF_GAIN  = 0.38f;
+    static constexpr float IN_GAIN      = 0.5f;
+    static constexpr float OUT_GAIN     = 0.56f;
+
+    void init() {
+        const float rateScale = g_sampleRate / SAMPLE_RATE;
+        used = 0;
+        for (int c = 0; c < LINES; c++) {
+            int len = FDN_LENGTHS_44K[c];
+            if (rateScale != 1.0f) len = next_prime((int)(len * rateScale + 0.5f));
+            if (len <= BLOCK_FRAMES) len = next_prime(BLOCK_FRAMES + 1);   // low rates
+            int ring = 1;
+            while (ring < len) ring <<= 1;
+            length[c] = len;
+            base[c]   = used;
+            mask[c]   = (uint32_t)(ring - 1);
+            used     += ring;
+
+            float passes = len / (REF_LEN * rateScale);   // comb loops per line loop
+            float hf = powf(REF_HF_GAIN, passes);
+            lpCoeff[c] = (1.0f - hf) / (1.0f + hf);
+            gain[c]    = powf(REF_FEEDBACK, passes) * 0.35355339f;   // 1/√8
+        }
+        clear();
+    }
+
+    void clear() {
+        memset(arena, 0, used * sizeof(float));
+        for (int c = 0; c < LINES; c++) lpState[c] = 0.0f;
+        pos = 0;
+    }
+
+    void updateFromDynamics(float len, float releaseNorm) {
+        amount = len * (0.5f + 0.5f * releaseNorm);
+        wet = amount * 0.85f;
+    }
+
+    // Block render (n ≤ BLOCK_FRAMES). Every line is longer than a block,
+    // so a sample never reads what this block writes: gather all reads,
+    // run the mix on frame-major vectors, then scatter the writes.
+    // Taps are rows 2 (L) and 1 (R) of H4(a + b) — orthogonal sign patterns.
+    // inL feeds lines 0..3 and inR lines 4..7 (one buffer twice for mono).
+    void process(const float* inL, const float* inR, float* outL, float* outR, int n) {
+        PROBE(PROBE_REVERB);
+        for (int c = 0; c < LINES; c++) {
+            const float* src = arena + base[c];
+            const uint32_t m = mask[c];
+            uint32_t r = (pos - (uint32_t)length[c]) & m;
+            for (int i = 0; i < n; ) {
+                int run = (int)(m + 1 - r);   // up to the ring end
+                if (run > n - i) run = n - i;
+                for (int k = 0; k < run; k++) frame[(i + k) * LINES + c] = src[r + k];
+                i += run;
+                r = (r + run) & m;
+            }
+        }
+
+        v4f lpA = *(const v4f*)&lpState[0], lpB = *(const v4f*)&lpState[4];
+        const v4f cA = *(const v4f*)&lpCoeff[0], cB = *(const v4f*)&lpCoeff[4];
+        const v4f gA = *(const v4f*)&gain[0],    gB = *(const v4f*)&gain[4];
+        for (int i = 0; i < n; i++) {
+            v4f* f = (v4f*)&frame[i * LINES];
+            v4f a = f[0], b = f[1];
+            v4f taps = hadamard4(a + b);
+            outL[i] = OUT_GAIN * taps[2];
+            outR[i] = OUT_GAIN * taps[1];
+
+            // Damping, gain, then H8 = [H4 H4; H4 -H4]
+            lpA = a + cA * (lpA - a);
+            lpB = b + cB * (lpB - b);
+            v4f ha = hadamard4(lpA * gA), hb = hadamard4(lpB * gB);
+            f[0] = ha + hb + v4f_set1(inL[i] * IN_GAIN);
+            f[1] = ha - hb + v4f_set1(inR[i] * IN_GAIN);
+        }
+        *(v4f*)&lpState[0] = flush_denormal(lpA);
+        *(v4f*)&lpState[4] = flush_denormal(lpB);
+
+        for (int c = 0; c < LINES; c++) {
+            float* dst = arena + base[c];
+            const uint32_t m = mask[c];
+            uint32_t w = pos & m;
+            for (int i = 0; i < n; ) {
+                int run = (int)(m + 1 - w);
+                if (run > n - i) run = n - i;
+                for (int k = 0; k < run; k++) dst[w + k] = frame[(i + k) * LINES + c];
+                i += run;
+                w = (w + run) & m;
+            }
+        }
+        pos += (uint32_t)n;
+
+        float pl = block_peak(outL, n), pr = block_peak(outR, n);
+        tailPeak = pl > pr ? pl : pr;
+        for (int i = 0; i < n; i++) {
+            outL[i] = inL[i] + wet * (outL[i] - inL[i]);
+            outR[i] = inR[i] + wet * (outR[i] - inR[i]);
+        }
+    }
+};
+
+// ─── MIDI note → frequency ──────────────────────────────────────────────────
+
+static inline float mtof(int note) {
+    return 440.0f * exp2f((note - 69) / 12.0f);
+}
+
+// ─── Voice ───────────────────────────────────────────────────────────────────
+
+struct Voice {
+    NoteStack  stack;
+    Oscillator osc;
+    UnisonOsc  uni;        // copies > 0: replaces osc (processUnison)
+    Portamento porta;
+    SVFilter   filt;
+    SVFilter   filtSide;   // unison side channel; runs on filt's coefficients
+    Envelope   env;
+    bool       gateOn = false;
+    int        targetWaveform = 0;
+    float      morphPos = 0.0f;
+    StageClock* clock = nullptr;   // bench only
+
+    void noteOn(int note) {
+        bool legato = gateOn;
+        stack.push(note);
+        float freq = mtof(note);
+        if (legato) {
+            porta.setTarget(freq);
+        } else {
+            porta.snap(freq);
+            env.gate(true);
+        }
+        gateOn = true;
+    }
+
+    void noteOff(int note) {
+        stack.remove(note);
+        if (stack.empty()) {
+            env.gate(false);
+            gateOn = false;
+        } else {
+            // Glide to the new top note (legato)
+            porta.setTarget(mtof(stack.top()));
+        }
+    }
+
+    float tick() {
+        osc.freq = porta.tick();
+        osc.advance();
+
+        // Smooth morphPos toward targetWaveform (reuses portamento speed)
+        float target = (float)targetWaveform;
+        morphPos += porta.coeff * (target - morphPos);
+        if (fabsf(morphPos - target) < 0.001f) morphPos = target;
+
+        // Crossfade between adjacent waveforms during morph
+        float s;
+        int lo = (int)floorf(morphPos);
+        float frac = morphPos - (float)lo;
+        int loIdx = ((lo % NUM_WAVEFORMS) + NUM_WAVEFORMS) % NUM_WAVEFORMS;
+
+        if (frac < 0.001f) {
+            s = osc.waveform(loIdx);
+        } else {
+            int hiIdx = (loIdx + 1) % NUM_WAVEFORMS;
+            s = osc.waveform(loIdx) * (1.0f - frac) + osc.waveform(hiIdx) * frac;
+        }
+
+        s = filt.tick(s);
+        s *= env.tick();
+        return s;
+    }
+
+    bool idle() const { return env.stage == Envelope::OFF; }
+
+    // Idle fast path: the envelope is at 0, so the output is silence. Glides
+    // and the morph settle where they would have ended up; oscillator and
+    // filter state hold until the next note (masked by its attack).
+    void skip(float* buf, int n) {
+        for (int i = 0; i < n; i++) buf[i] = 0.0f;
+        porta.current = porta.target;
+        morphPos = (float)targetWaveform;
+    }
+
+    // Block render: portamento → morph → oscillator → filter → envelope,
+    // each stage a separate loop over the block. Null a1s/a2s/a3s: the
+    // coefficients are at rest, filt's own hold for the whole block.
+    void process(float* buf, const float* pws, const float* a1s,
+                 const float* a2s, const float* a3s, int n) {
+        float freqs[BLOCK_FRAMES];
+        float morph[BLOCK_FRAMES];
+
+        porta.process(freqs, n);
+        morphRamp(morph, n);
+
+        osc.process(buf, freqs, pws, morph, n);
+        STAGE_LAP(clock, STAGE_OSC);
+        if (a1s) filt.process(buf, a1s, a2s, a3s, n);
+        else     filt.process(buf, n);
+        STAGE_LAP(clock, STAGE_FILTER);
+        env.process(buf, n);
+        STAGE_LAP(clock, STAGE_ENV);
+    }
+
+    // Unison block render: same chain on the stack's mid and side signals.
+    // The side gets its own filter state and the same envelope gain.
+    void processUnison(float* mid, float* side, const float* pws, const float* a1s,
+                       const float* a2s, const float* a3s, int n) {
+        float freqs[BLOCK_FRAMES];
+        float morph[BLOCK_FRAMES];
+        float gain[BLOCK_FRAMES];
+
+        porta.process(freqs, n);
+        morphRamp(morph, n);
+
+        uni.process(mid, side, freqs, pws, morph, osc.pwmRatio, n);
+        if (n > 0) osc.pulseWidth = pws[n - 1];   // held width in Ratio PWM mode
+        STAGE_LAP(clock, STAGE_OSC);
+        if (a1s) {
+            filt.process(mid, a1s, a2s, a3s, n);
+            filtSide.process(side, a1s, a2s, a3s, n);
+        } else {
+            filtSide.a1 = filt.a1; filtSide.a2 = filt.a2; filtSide.a3 = filt.a3;
+            filt.process(mid, n);
+            filtSide.process(side, n);
+        }
+        STAGE_LAP(clock, STAGE_FILTER);
+        for (int i = 0; i < n; i++) gain[i] = 1.0f;
+        env.process(gain, n);
+        for (int i = 0; i < n; i++) { mid[i] *= gain[i]; side[i] *= gain[i]; }
+        STAGE_LAP(clock, STAGE_ENV);
+    }
+
+    // Scalar reference for process() (bench --check): the per-sample tick()
+    // chain, fed the same pulse-width and filter coefficient ramps
+    void processReference(float* buf, const float* pws, const float* a1s,
+                          const float* a2s, const float* a3s, int n) {
+        for (int i = 0; i < n; i++) {
+            osc.pulseWidth = pws[i];
+            if (a1s) { filt.a1 = a1s[i]; filt.a2 = a2s[i]; filt.a3 = a3s[i]; }
+            buf[i] = tick();
+        }
+    }
+
+private:
+    // Smooth morphPos toward targetWaveform (reuses portamento speed)
+    void morphRamp(float* morph, int n) {
+        float target = (float)targetWaveform;
+        for (int i = 0; i < n; i++) {
+            morphPos += porta.coeff * (target - morphPos);
+            if (fabsf(morphPos - target) < 0.001f) morphPos = target;
+            morph[i] = morphPos;
+        }
+    }
+};
+
+// ─── Polyphonic voice pool (structure-of-arrays, one v4f lane per voice) ────
+// Each field holds all four voices side by side, so every per-sample stage
+// (phase advance, BLEPs, SVF, envelope) is one vector op across the pool.
+// Written with v4f only: on targets without NEON/SSE the generic vectors
+// lower to scalar code.
+
+static constexpr int   POLY_VOICES = 4;
+static constexpr float POLY_GAIN   = 0.5f;   // ~1/sqrt(voices): chords stay in range
+
+struct PolyVoices {
+    // Per-voice state, SoA
+    alignas(16) float phase[POLY_VOICES]    = {};
+    alignas(16) float pwmPhase[POLY_VOICES] = {};
+    alignas(16) float freq[POLY_VOICES]     = {440.0f, 440.0f, 440.0f, 440.0f};
+    alignas(16) float portaCur[POLY_VOICES] = {};   // log2(freq)
+    alignas(16) float portaTgt[POLY_VOICES] = {};
+    alignas(16) float ic1eq[POLY_VOICES]    = {};
+    alignas(16) float ic2eq[POLY_VOICES]    = {};
+    alignas(16) float envValue[POLY_VOICES] = {};
+    Envelope::Stage envStage[POLY_VOICES]   = {Envelope::OFF, Envelope::OFF,
+                                               Envelope::OFF, Envelope::OFF};
+    int      note[POLY_VOICES] = {-1, -1, -1, -1};
+    uint32_t age[POLY_VOICES]  = {};   // note-on order, for oldest-first stealing
+    uint32_t ageCounter = 0;
+
+    // Shared across the pool (same knobs as the mono voice)
+    float portaCoeff   = 1.0f;
+    float pwmRatio     = 1.0f;
+    float pulseWidth   = 0.5f;   // last pulse width used (held in Ratio PWM mode)
+    float attackCoeff  = 0.0f;
+    float releaseCoeff = 0.0f;
+    int   targetWaveform = 0;
+    float morphPos     = 0.0f;
+    const Wavetables* wt = nullptr;
+    StageClock* clock = nullptr;   // bench only
+
+    PolyVoices() {
+        Envelope e;
+        attackCoeff  = e.attackCoeff;
+        releaseCoeff = e.releaseCoeff;
+    }
+
+    // Free voice (oldest first), else the quietest releasing voice, else the
+    // oldest held one. A note already sounding retriggers its own voice.
+    int allocate(int n) const {
+        for (int v = 0; v < POLY_VOICES; v++)
+            if (note[v] == n && envStage[v] != Envelope::OFF) return v;
+        int best = -1;
+        for (int v = 0; v < POLY_VOICES; v++)
+            if (envStage[v] == Envelope::OFF && (best < 0 || age[v] < age[best])) best = v;
+        if (best >= 0) return best;
+        for (int v = 0; v < POLY_VOICES; v++)
+            if (envStage[v] == Envelope::RELEASE && (best < 0 || envValue[v] < envValue[best]))
+                best = v;
+        if (best >= 0) return best;
+        best = 0;
+        for (int v = 1; v < POLY_VOICES; v++)
+            if (age[v] < age[best]) best = v;
+        return best;
+    }
+
+    void noteOn(int n) {
+        int v = allocate(n);
+        float target = log2f(mtof(n));
+        portaTgt[v] = target;
+        if (envStage[v] == Envelope::OFF) {
+            portaCur[v] = target;   // idle voice: start on pitch
+            freq[v] = mtof(n);
+        }                           // stolen/retriggered voice glides from its pitch
+        note[v] = n;
+        age[v] = ++ageCounter;
+        envStage[v] = Envelope::ATTACK;
+    }
+
+    void noteOff(int n) {
+        for (int v = 0; v < POLY_VOICES; v++)
+            if (note[v] == n && envStage[v] == Envelope::ATTACK)
+                envStage[v] = Envelope::RELEASE;
+    }
+
+    bool idle() const {
+        for (int v = 0; v < POLY_VOICES; v++)
+            if (envStage[v] != Envelope::OFF) return false;
+        return true;
+    }
+
+    // Idle fast path (see Voice::skip)
+    void skip(float* buf, int n) {
+        for (int i = 0; i < n; i++) buf[i] = 0.0f;
+        for (int v = 0; v < POLY_VOICES; v++) portaCur[v] = portaTgt[v];
+        morphPos = (float)targetWaveform;
+    }
+
+    bool gliding() const {
+        for (int v = 0; v < POLY_VOICES; v++)
+            if (portaCur[v] != portaTgt[v]) return true;
+        return false;
+    }
+
+    // One waveform for all four voices; fr is this sample's (gliding)
+    // frequency, which picks the mip level as in the mono oscillator
+    template <bool Table>
+    v4f wave(int idx, v4f ph, v4f pwmPh, v4f fr, v4f dt, v4f invDt, float pw) const {
+        if (Table) {
+            v4f s;
+            for (int v = 0; v < POLY_VOICES; v++) {
+                const int k = Wavetables::octaveFor(fr[v]);
+                float p = ph[v], q;
+                switch (idx) {
+                case 1:  q = pw; break;
+                case 2:  s[v] = Wavetables::lookup(wt->tri[k], p); continue;
+                case 3:  q = 0.5f + 0.4f * Wavetables::lookup(wt->sine, pwmPh[v]); break;
+                default: s[v] = Wavetables::lookup(wt->saw[k], p); continue;
+                }
+                float sh = p - q;
+                if (sh < 0.0f) sh += 1.0f;
+                s[v] = Wavetables::lookup(wt->saw[k], sh) - Wavetables::lookup(wt->saw[k], p)
+                     + 2.0f * q - 1.0f;
+            }
+            return s;
+        }
+        return v4f_blep_wave(idx, ph, pwmPh, dt, invDt, pw);
+    }
+
+    void process(float* buf, const float* pws, const float* a1s,
+                 const float* a2s, const float* a3s, int n) {
+        PROBE(PROBE_POOL);
+        if (wt) processWith<true>(buf, pws, a1s, a2s, a3s, n);
+        else    processWith<false>(buf, pws, a1s, a2s, a3s, n);
+    }
+
+    // Block render: portamento → morph → oscillator → SVF → envelope per
+    // sample, all four voices per vector op, summed to mono
+    template <bool Table>
+    void processWith(float* buf, const float* pws, const float* a1s,
+                     const float* a2s, const float* a3s, int n) {
+        const v4f one = v4f_set1(1.0f);
+        v4f ph  = *(const v4f*)phase,  pwmPh = *(const v4f*)pwmPhase;
+        v4f s1  = *(const v4f*)ic1eq,  s2    = *(const v4f*)ic2eq;
+        v4f env = *(const v4f*)envValue;
+        v4f fr  = *(const v4f*)freq;
+        v4f cur = *(const v4f*)portaCur;
+        const v4f tgt = *(const v4f*)portaTgt;
+        const v4f pc  = v4f_set1(portaCoeff);
+        const bool glide = gliding();
+
+        v4i isAttack, isRelease;
+        for (int v = 0; v < POLY_VOICES; v++) {
+            isAttack[v]  = envStage[v] == Envelope::ATTACK  ? -1 : 0;
+            isRelease[v] = envStage[v] == Envelope::RELEASE ? -1 : 0;
+        }
+        const v4f ac = v4f_set1(attackCoeff), rc = v4f_set1(releaseCoeff);
+        const float target = (float)targetWaveform;
+
+        v4f dt = fr * g_invSR, invDt = one / dt;
+        for (int i = 0; i < n; i++) {
+            if (glide) {
+                cur += pc * (tgt - cur);
+                for (int v = 0; v < POLY_VOICES; v++) fr[v] = dsp_exp2(cur[v]);
+                dt = fr * g_invSR;
+                invDt = one / dt;
+            }
+
+            ph += dt;
+            ph = v4f_select(ph >= one, ph - one, ph);
+            pwmPh += dt * pwmRatio;
+            for (int v = 0; v < POLY_VOICES; v++)
+                if (pwmPh[v] >= 1.0f) pwmPh[v] -= floorf(pwmPh[v]);
+
+            morphPos += portaCoeff * (target - morphPos);
+            if (fabsf(morphPos - target) < 0.001f) morphPos = target;
+            int lo = (int)floorf(morphPos);
+            float frac = morphPos - (float)lo;
+            int loIdx = ((lo % NUM_WAVEFORMS) + NUM_WAVEFORMS) % NUM_WAVEFORMS;
+            v4f x = wave<Table>(loIdx, ph, pwmPh, fr, dt, invDt, pws[i]);
+            if (frac >= 0.001f) {
+                int hiIdx = (loIdx + 1) % NUM_WAVEFORMS;
+                x = x * (1.0f - frac) + wave<Table>(hiIdx, ph, pwmPh, fr, dt, invDt, pws[i]) * frac;
+            }
+
+            // SVF (shared coefficients, per-voice state)
+            v4f v3 = x - s2;
+            v4f v1 = a1s[i] * s1 + a2s[i] * v3;
+            v4f v2 = s2 + a2s[i] * s1 + a3s[i] * v3;
+            s1 = 2.0f * v1 - s1;
+            s2 = 2.0f * v2 - s2;
+
+            // AR envelope: attack lanes rise, release lanes decay, off lanes hold 0
+            v4f att = env + ac * (one - env);
+            att = v4f_select(att > v4f_set1(0.999f), one, att);
+            v4f rel = env * rc;
+            rel = v4f_select(rel < v4f_set1(0.0001f), v4f_set1(0.0f), rel);
+            env = v4f_select(isAttack, att, v4f_select(isRelease, rel, env));
+
+            v4f y = v2 * env;
+            buf[i] = ((y[0] + y[1]) + (y[2] + y[3])) * POLY_GAIN;
+        }
+
+        *(v4f*)phase = ph;   *(v4f*)pwmPhase = pwmPh;
+        *(v4f*)ic1eq = flush_denormal(s1);   *(v4f*)ic2eq = flush_denormal(s2);
+        *(v4f*)envValue = env;
+        *(v4f*)freq = fr;    *(v4f*)portaCur = cur;
+        for (int v = 0; v < POLY_VOICES; v++) {
+            if (envStage[v] == Envelope::RELEASE && envValue[v] == 0.0f)
+                envStage[v] = Envelope::OFF;
+            if (fabsf(portaCur[v] - portaTgt[v]) < 1e-6f) portaCur[v] = portaTgt[v];
+        }
+        if (n > 0) pulseWidth = pws[n - 1];
+        STAGE_LAP(clock, STAGE_OSC);
+    }
+};
+
+// ─── Control-rate (k-rate) parameters ───────────────────────────────────────
+// A k-rate parameter is a one-pole-smoothed target evaluated only every
+// `interval` samples (the exact one-pole response at those points, via a
+// decay table); linear ramps carry it — or coefficients derived from it —
+// across each interval, so there is no zipper noise.
+
+struct ControlRate {
+    int   interval = CONTROL_INTERVAL;
+    float decay[BLOCK_FRAMES + 1];   // (1 - PARAM_SMOOTH_COEFF)^m
+    float inv[BLOCK_FRAMES + 1];     // 1/m
+
+    void init(int samples) {
+        interval = samples < 1 ? 1 : (samples > BLOCK_FRAMES ? BLOCK_FRAMES : samples);
+        // PARAM_SMOOTH_COEFF is per 44.1 kHz sample; keep its time constant
+        float base = powf(1.0f - PARAM_SMOOTH_COEFF, SAMPLE_RATE / g_sampleRate);
+        for (int m = 0; m <= BLOCK_FRAMES; m++) {
+            decay[m] = powf(base, (float)m);
+            inv[m]   = m > 0 ? 1.0f / m : 0.0f;
+        }
+    }
+};
+
+static constexpr float PARAM_SNAP = 1e-5f;   // relative distance that counts as "at target"
+
+// out[i] = from + step * (i + 1) for i < m: no running sum, so every lane is
+// independent and four go per v4f
+static inline void linear_ramp(float* out, float from, float step, int m) {
+    const v4f lane = {1.0f, 2.0f, 3.0f, 4.0f};
+    int i = 0;
+    for (; i + 4 <= m; i += 4) {
+        v4f r = v4f_set1(from) + v4f_set1(step) * (lane + v4f_set1((float)i));
+        memcpy(out + i, &r, sizeof(r));   // scratch buffers need not be 16-aligned
+    }
+    for (; i < m; i++) out[i] = from + step * (float)(i + 1);
+}
+
+struct KRateParam {
+    float target = 0.0f;
+    float value  = 0.0f;   // smoothed value at the last control point
+    // Ramp-buffer cache: constBuf[0..constN) holds constVal. Keyed on the
+    // buffer and the value, so a value set directly (patch recall, init)
+    // just misses the cache
+    const float* constBuf = nullptr;
+    float        constVal = 0.0f;
+    int          constN   = 0;
+
+    bool atTarget() const { return value == target; }
+
+    // Step to the next control point, m samples ahead. Snaps onto the
+    // target once within PARAM_SNAP, so a settled knob reaches atTarget()
+    float advance(int m, const ControlRate& cr) {
+        value = flush_denormal(target + (value - target) * cr.decay[m]);
+        if (fabsf(value - target) <= PARAM_SNAP * (fabsf(target) + 0.01f)) value = target;
+        return value;
+    }
+
+    // Fill out[0..n) with linear ramps between control points. At target
+    // the block is the constant `value`: returns true, and only writes the
+    // entries that don't already hold it (none, once it has settled)
+    bool ramp(float* out, int n, const ControlRate& cr) {
+        if (atTarget()) {
+            if (out != constBuf || value != constVal) {
+                constBuf = out;
+                constVal = value;
+                constN   = 0;
+            }
+            for (int i = constN; i < n; i++) out[i] = value;
+            if (n > constN) constN = n;
+            return true;
+        }
+        constN = 0;   // out is being overwritten with a ramp
+        for (int k = 0; k < n; k += cr.interval) {
+            int m = (n - k < cr.interval) ? n - k : cr.interval;
+            float v = value;
+            float step = (advance(m, cr) - v) * cr.inv[m];
+            linear_ramp(out + k, v, step, m);
+            out[k + m - 1] = value;   // land exactly on the control point
+        }
+        return false;
+    }
+};
+
+// ─── Modulation matrix (block-rate sources → destinations) ─────────────────
+// Routing is MOD_SLOTS (source, destination, depth) triples stored as three
+// flat arrays; source values and destination sums are flat arrays too, so
+// evaluation is one multiply-accumulate per slot per block. Destinations:
+// PW is an offset around 0.5, CUTOFF is in octaves, RESO is added, DIST and
+// REVERB replace the play-style inputs (speed, length) of those effects.
+// The PWM LFO is the one audio-rate source: its slots are folded into
+// lfoDepth[] once per routing change, applied per sample by PW and at the
+// block's last LFO value by every other destination.
+
+enum ModSource : uint8_t { MOD_SRC_LFO, MOD_SRC_ENV, MOD_SRC_SPEED, MOD_SRC_LENGTH,
+                           MOD_SRC_RELEASE, MOD_SOURCES };
+enum ModDest   : uint8_t { MOD_DST_PW, MOD_DST_CUTOFF, MOD_DST_RESO, MOD_DST_DIST,
+                           MOD_DST_REVERB, MOD_DESTS };
+static constexpr int MOD_SLOTS = 8;
+
+struct ModMatrix {
+    uint8_t source[MOD_SLOTS];
+    uint8_t dest[MOD_SLOTS];
+    float   depth[MOD_SLOTS];
+    float   blockDepth[MOD_SLOTS];      // depth, or 0 for LFO slots
+    float   lfoDepth[MOD_DESTS] = {};   // summed LFO depth per destination
+    float   src[MOD_SOURCES]    = {};   // this block's source values
+    float   base[MOD_DESTS]     = {};   // block-rate sums without the LFO
+    float   out[MOD_DESTS]      = {};   // base + LFO at the block's end
+
+    // The hard-wired routings this matrix replaced; the rest of the slots
+    // start at depth 0
+    ModMatrix() {
+        for (int k = 0; k < MOD_SLOTS; k++) set(k, MOD_SRC_LFO, MOD_DST_PW, 0.0f);
+        set(0, MOD_SRC_LFO,    MOD_DST_PW,     0.4f);
+        set(1, MOD_SRC_SPEED,  MOD_DST_DIST,   1.0f);
+        set(2, MOD_SRC_LENGTH, MOD_DST_REVERB, 1.0f);
+    }
+
+    // Out-of-range slot/source/destination: ignored
+    void set(int slot, int s, int d, float amount) {
+        if (slot < 0 || slot >= MOD_SLOTS || s < 0 || s >= MOD_SOURCES
+            || d < 0 || d >= MOD_DESTS || !(fabsf(amount) < 1e6f)) return;
+        source[slot]     = (uint8_t)s;
+        dest[slot]       = (uint8_t)d;
+        depth[slot]      = amount;
+        blockDepth[slot] = (s == MOD_SRC_LFO) ? 0.0f : amount;
+        for (int k = 0; k < MOD_DESTS; k++) lfoDepth[k] = 0.0f;
+        for (int k = 0; k < MOD_SLOTS; k++)
+            if (source[k] == MOD_SRC_LFO) lfoDepth[dest[k]] += depth[k];
+    }
+
+    // src[] filled by the caller (src[MOD_SRC_LFO] = the block's last value)
+    void evaluate() {
+        for (int d = 0; d < MOD_DESTS; d++) base[d] = 0.0f;
+        for (int k = 0; k < MOD_SLOTS; k++) base[dest[k]] += blockDepth[k] * src[source[k]];
+        for (int d = 0; d < MOD_DESTS; d++) out[d] = base[d] + lfoDepth[d] * src[MOD_SRC_LFO];
+    }
+};
+
+// ─── Lock-free single-producer/single-consumer ring ────────────────────────
+
+template <typename T, uint32_t N>
+struct SpscRing {
+    static_assert((N & (N - 1)) == 0, "ring size must be a power of two");
+    T items[N];
+    std::atomic<uint32_t> head{0};   // written by producer only
+    std::atomic<uint32_t> tail{0};   // written by consumer only
+
+    bool push(const T& v) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == N) return false;  // full
+        items[h & (N - 1)] = v;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& v) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;      // empty
+        v = items[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Free slots as seen by the producer (the consumer can only add to it)
+    uint32_t space() const {
+        return N - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+    }
+
+    // Copy of the oldest item without consuming it
+    bool peek(T& v) const {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        v = items[t & (N - 1)];
+        return true;
+    }
+};
+
+// ─── Control → audio events (pre-decoded: no libm on the audio thread) ──────
+
+struct ParamEvent {
+    enum Type : uint8_t {
+        NOTE_ON, NOTE_OFF, WAVEFORM,
+        PORTA,       // a = portamento coeff, b = PWM LFO freq (Hz)
+        PWM_RATIO,   // a = ratio
+        CUTOFF,      // a = Hz
+        RESO,        // a = 0–0.95
+        RELEASE,     // a = release coeff, b = releaseNorm
+        VOLUME,      // a = 0–1
+        MOD_ROUTE,   // i = slot | source << 8 | dest << 16, a = depth
+        PATCH        // i = PatchPool slot (whole parameter set, decoded)
+    };
+    Type     type;
+    int32_t  i;       // note / waveform index
+    float    a, b;
+    uint64_t timeNs;  // arrival time (CLOCK_MONOTONIC)
+};
+
+// Audio → control, once per period
+struct MeterFrame {
+    float peak;           // max |out| over the period
+    float distAmount;
+    float reverbAmount;
+    uint32_t renderNs;    // DSP time for the period (filled by the audio thread)
+    uint32_t wallNs;      // period start-to-start, incl. PCM waits
+    uint32_t frames;      // period length the render/wall times refer to
+};
+
+typedef SpscRing<ParamEvent, 256> ParamQueue;
+
+// /knobs decoding only queues its events while this many slots stay free,
+// so the ordered events (notes above all) always find room behind a burst
+static constexpr uint32_t PARAM_NOTE_RESERVE = 32;
+static constexpr uint32_t KNOB_EVENTS        = 5;   // events per decoded /knobs
+
+static inline bool knob_room(const ParamQueue& q) {
+    return q.space() >= KNOB_EVENTS + PARAM_NOTE_RESERVE;
+}
+
+// ─── Presets: stored snapshot → decoded patch → audio-side swap ─────────────
+// A Preset is the raw control state (10-bit knob values, waveform, mod
+// routing) in a fixed on-disk layout. The control thread decodes it into a
+// SynthPatch in a PatchPool slot and sends one PATCH event; the audio thread
+// copies the whole set in apply(), between two render chunks.
+
+static constexpr int      PRESET_SLOTS = 32;
+static constexpr uint32_t PRESET_MAGIC = 0x3150534d;   // "MSP1"
+
+struct Preset {                  // 64 bytes, little-endian; append-only layout
+    uint16_t porta, ratio;       // K1 in the two waveform modes
+    uint16_t cutoff, reso, release, volume;   // K2–K5
+    uint8_t  waveform;
+    uint8_t  used;               // 0 = empty slot
+    uint16_t reserved;
+    uint8_t  modSource[MOD_SLOTS];
+    uint8_t  modDest[MOD_SLOTS];
+    float    modDepth[MOD_SLOTS];
+};
+static_assert(sizeof(Preset) == 64, "Preset is an on-disk layout");
+
+struct SynthPatch {
+    float portaCoeff, lfoFreq, pwmRatio;
+    float cutoffHz, reso, releaseCoeff, releaseNorm, volume;
+    int   waveform;
+    uint8_t modSource[MOD_SLOTS];
+    uint8_t modDest[MOD_SLOTS];
+    float   modDepth[MOD_SLOTS];
+};
+
+// Single producer (control) / single consumer (audio): a slot is rewritten
+// only after the audio thread has applied every patch issued before it
+struct PatchPool {
+    static constexpr uint32_t SIZE = 4;
+    SynthPatch slot[SIZE];
+    std::atomic<uint32_t> issued{0};    // control thread
+    std::atomic<uint32_t> applied{0};   // audio thread
+
+    SynthPatch* next() {
+        uint32_t i = issued.load(std::memory_order_relaxed);
+        if (i - applied.load(std::memory_order_acquire) >= SIZE) return nullptr;
+        return &slot[i % SIZE];
+    }
+};
+
+// ─── Synth engine (all audio-thread state) ──────────────────────────────────
+
+struct Synth {
+    Voice       voice;      // mono mode (NoteStack legato)
+    PolyVoices  pool;       // poly mode
+    bool        poly = false;
+    TriLFO      pwmLfo;
+    NoteTracker tracker;
+    Distortion  dist;
+    Distortion  distR;   // right channel of a unison stack (dist takes the left)
+    Reverb      reverb;
+    FdnReverb   fdn;
+    bool        fdnReverb = false;   // FDN engine instead of the Schroeder bank
+    bool        reference = false;   // bench --check: scalar per-sample mono voice
+                                     // and Schroeder reverb instead of the block kernels
+
+    ModMatrix   mod;
+    ControlRate ctl;
+    KRateParam  cutoff{8000.0f, 8000.0f};
+    KRateParam  reso{0.0f, 0.0f};
+    KRateParam  vol{0.5f, 0.5f};
+    Activity    distActivity;     // oversampling filters ring briefly
+    Activity    reverbActivity;   // tail can last seconds
+    float releaseNorm  = 0.0f;
+    float cutoffScale  = 1.0f;   // 2^(cutoff modulation), this block
+    float peakLevel    = 0.0f;   // since last takeMeter()
+    StageClock* clock  = nullptr;   // bench only; see setClock()
+    PatchPool*  patches = nullptr;  // PATCH events index into this
+
+    // DSP scratch
+    float a1Buf[BLOCK_FRAMES], a2Buf[BLOCK_FRAMES], a3Buf[BLOCK_FRAMES], volBuf[BLOCK_FRAMES];
+    // Settled-coefficient cache: a*Buf[0..coeffConstN) hold coeffConst
+    float coeffConst[3] = {NAN, NAN, NAN};
+    int   coeffConstN   = 0;
+    float lfoBuf[BLOCK_FRAMES], pwBuf[BLOCK_FRAMES];
+    float monoBuf[BLOCK_FRAMES], outLBuf[BLOCK_FRAMES], outRBuf[BLOCK_FRAMES];
+    float sideBuf[BLOCK_FRAMES];   // unison side signal, then the reverb's R input
+
+    void setClock(StageClock* c) { clock = c; voice.clock = c; pool.clock = c; }
+
+    // Wavetable engine for both voice modes (null = PolyBLEP)
+    void setWavetables(const Wavetables* wt) { voice.osc.wt = wt; pool.wt = wt; }
+
+    // Mono-mode unison stack (copies < 2 = off); before the audio thread starts
+    void setUnison(int copies, float cents, float spread) { voice.uni.init(copies, cents, spread); }
+    void setOversample(int factor) { dist.setOversample(factor); distR.setOversample(factor); }
+
+    void init(int controlInterval = CONTROL_INTERVAL, bool polyMode = false,
+              bool fdnMode = false) {
+        poly = polyMode;
+        fdnReverb = fdnMode;
+        ctl.init(controlInterval);
+        if (fdnReverb) fdn.init();
+        else           reverb.init();
+        voice.filt.setParams(cutoff.value, reso.value);
+        voice.porta.setTime(0.0f);
+    }
+
+    float modReso(float r) const {
+        r += mod.out[MOD_DST_RESO];
+        return r < 0.0f ? 0.0f : (r > 0.95f ? 0.95f : r);
+    }
+
+    // SVF coefficients: recomputed (tan + division) once per control point,
+    // linearly ramped in between. voice.filt holds the coefficients in both
+    // modes; the pool shares them across its voices. Returns true when they
+    // hold still for the whole block (cutoff and reso at target, modulation
+    // unchanged): the mono voice then filters on voice.filt's coefficients
+    // directly, and the arrays are only rewritten while they don't already
+    // hold those coefficients (compared, so a setParams elsewhere is caught).
+    bool filterRamp(int n) {
+        SVFilter& f = voice.filt;
+        if (cutoff.atTarget() && reso.atTarget()
+            && f.holds(cutoff.value * cutoffScale, modReso(reso.value))) {
+            if (f.a1 != coeffConst[0] || f.a2 != coeffConst[1] || f.a3 != coeffConst[2]) {
+                coeffConst[0] = f.a1; coeffConst[1] = f.a2; coeffConst[2] = f.a3;
+                coeffConstN = 0;
+            }
+            for (int i = coeffConstN; i < n; i++) { a1Buf[i] = f.a1; a2Buf[i] = f.a2; a3Buf[i] = f.a3; }
+            if (n > coeffConstN) coeffConstN = n;
+            return true;
+        }
+        coeffConstN = 0;   // the arrays are being overwritten with ramps
+        for (int k = 0; k < n; k += ctl.interval) {
+            int m = (n - k < ctl.interval) ? n - k : ctl.interval;
+            float p1 = f.a1, p2 = f.a2, p3 = f.a3;
+            float c = cutoff.advance(m, ctl) * cutoffScale;
+            f.setParams(c, modReso(reso.advance(m, ctl)));   // no-op once settled
+            linear_ramp(a1Buf + k, p1, (f.a1 - p1) * ctl.inv[m], m);
+            linear_ramp(a2Buf + k, p2, (f.a2 - p2) * ctl.inv[m], m);
+            linear_ramp(a3Buf + k, p3, (f.a3 - p3) * ctl.inv[m], m);
+            a1Buf[k + m - 1] = f.a1; a2Buf[k + m - 1] = f.a2; a3Buf[k + m - 1] = f.a3;
+        }
+        return false;
+    }
+
+    void apply(const ParamEvent& ev) {
+        switch (ev.type) {
+        case ParamEvent::NOTE_ON:
+            if (poly) pool.noteOn(ev.i);
+            else      voice.noteOn(ev.i);
+            distActivity.wake();
+            reverbActivity.wake();
+            tracker.noteOn();
+            break;
+        case ParamEvent::NOTE_OFF:
+            tracker.noteOff();
+            if (poly) pool.noteOff(ev.i);
+            else      voice.noteOff(ev.i);
+            break;
+        case ParamEvent::WAVEFORM:
+            voice.targetWaveform = pool.targetWaveform = ev.i;
+            break;
+        case ParamEvent::PORTA:
+            voice.porta.coeff = pool.portaCoeff = ev.a;
+            pwmLfo.freq = ev.b;
+            break;
+        case ParamEvent::PWM_RATIO: voice.osc.pwmRatio = pool.pwmRatio = ev.a; break;
+        case ParamEvent::CUTOFF:    cutoff.target = ev.a; break;
+        case ParamEvent::RESO:      reso.target = ev.a; break;
+        case ParamEvent::RELEASE:
+            voice.env.releaseCoeff = pool.releaseCoeff = ev.a;
+            releaseNorm = ev.b;
+            break;
+        case ParamEvent::VOLUME:    vol.target = ev.a; break;
+        case ParamEvent::MOD_ROUTE:
+            mod.set(ev.i & 0xff, (ev.i >> 8) & 0xff, (ev.i >> 16) & 0xff, ev.a);
+            break;
+        case ParamEvent::PATCH:
+            if (patches) {
+                applyPatch(patches->slot[ev.i % PatchPool::SIZE]);
+                patches->applied.store(patches->applied.load(std::memory_order_relaxed) + 1,
+                                       std::memory_order_release);
+            }
+            break;
+        }
+    }
+
+    // Every knob-driven parameter plus waveform and routing; smoothed ones
+    // glide to their new targets as they would from a knob move
+    void applyPatch(const SynthPatch& p) {
+        voice.porta.coeff = pool.portaCoeff = p.portaCoeff;
+        pwmLfo.freq = p.lfoFreq;
+        voice.osc.pwmRatio = pool.pwmRatio = p.pwmRatio;
+        cutoff.target = p.cutoffHz;
+        reso.target   = p.reso;
+        voice.env.releaseCoeff = pool.releaseCoeff = p.releaseCoeff;
+        releaseNorm = p.releaseNorm;
+        vol.target  = p.volume;
+        voice.targetWaveform = pool.targetWaveform = p.waveform;
+        for (int k = 0; k < MOD_SLOTS; k++)
+            mod.set(k, p.modSource[k], p.modDest[k], p.modDepth[k]);
+    }
+
+    MeterFrame takeMeter() {
+        MeterFrame m{peakLevel, dist.amount, fdnReverb ? fdn.amount : reverb.amount, 0, 0, 0};
+        peakLevel = 0.0f;
+        return m;
+    }
+
+    // Render `frames` interleaved float frames (±MASTER_GAIN full scale) into
+    // out: stage-by-stage pipeline over BLOCK_FRAMES scratch. Conversion to
+    // the device format is a separate stage (convert_samples).
+    void render(float* out, int frames) {
+        PROBE(PROBE_RENDER);
+        for (int off = 0; off < frames; off += BLOCK_FRAMES) {
+            int nb = frames - off;
+            if (nb > BLOCK_FRAMES) nb = BLOCK_FRAMES;
+
+            if (clock) clock->start();
+
+            // PWM LFO (keeps phase advancing in ratio mode to avoid discontinuity)
+            pwmLfo.process(lfoBuf, nb);
+
+            // Update dynamics (~2.3s time constants — block rate is plenty)
+            bool allIdle = (poly ? pool.idle() : voice.idle())
+                        && distActivity.idle() && reverbActivity.idle();
+            if (allIdle) tracker.coast(nb);
+            else         tracker.process(nb);
+
+            // Modulation sources → destinations, once per block
+            float env = voice.env.value;
+            if (poly) {
+                env = 0.0f;
+                for (int v = 0; v < POLY_VOICES; v++)
+                    if (pool.envValue[v] > env) env = pool.envValue[v];
+            }
+            mod.src[MOD_SRC_LFO]     = lfoBuf[nb - 1];
+            mod.src[MOD_SRC_ENV]     = env;
+            mod.src[MOD_SRC_SPEED]   = tracker.speed;
+            mod.src[MOD_SRC_LENGTH]  = tracker.length;
+            mod.src[MOD_SRC_RELEASE] = releaseNorm;
+            mod.evaluate();
+
+            if (voice.targetWaveform != 3) {
+                float pw0 = 0.5f + mod.base[MOD_DST_PW], pwLfo = mod.lfoDepth[MOD_DST_PW];
+                for (int i = 0; i < nb; i++) {
+                    float pw = pw0 + pwLfo * lfoBuf[i];
+                    pwBuf[i] = pw < 0.05f ? 0.05f : (pw > 0.95f ? 0.95f : pw);
+                }
+            } else {
+                float held = poly ? pool.pulseWidth : voice.osc.pulseWidth;
+                for (int i = 0; i < nb; i++) pwBuf[i] = held;
+            }
+
+            float distIn = mod.out[MOD_DST_DIST], revIn = mod.out[MOD_DST_REVERB];
+            distIn = distIn < 0.0f ? 0.0f : (distIn > 1.0f ? 1.0f : distIn);
+            revIn  = revIn  < 0.0f ? 0.0f : (revIn  > 1.0f ? 1.0f : revIn);
+            dist.updateFromDynamics(distIn, releaseNorm);
+            distR.updateFromDynamics(distIn, releaseNorm);
+            if (fdnReverb) fdn.updateFromDynamics(revIn, releaseNorm);
+            else           reverb.updateFromDynamics(revIn, releaseNorm);
+
+            // k-rate smoothed parameters: filter coefficient and volume ramps
+            float cutMod = mod.out[MOD_DST_CUTOFF];
+            cutoffScale = (cutMod == 0.0f) ? 1.0f : dsp_exp2(cutMod);
+            // Settled coefficients: the mono voice gets null ramps (see Voice::process)
+            const bool coeffSteady = filterRamp(nb);
+            const float* a1s = coeffSteady ? nullptr : a1Buf;
+            const float* a2s = coeffSteady ? nullptr : a2Buf;
+            const float* a3s = coeffSteady ? nullptr : a3Buf;
+            vol.ramp(volBuf, nb, ctl);
+            STAGE_LAP(clock, STAGE_CONTROL);
+
+            // Signal chain: osc → filter → envelope → distortion → reverb.
+            // Idle stages (silent input, decayed state) skip to zeros.
+            // A unison stack adds a side signal: mid/side become L/R ahead of
+            // the distortion, which then shapes both channels.
+            bool voiceIdle = poly ? pool.idle() : voice.idle();
+            bool stereo = !poly && voice.uni.copies > 0;
+            if (!voiceIdle) {
+                if (poly)        pool.process(monoBuf, pwBuf, a1Buf, a2Buf, a3Buf, nb);
+                else if (stereo) voice.processUnison(monoBuf, sideBuf, pwBuf, a1s, a2s, a3s, nb);
+                else if (reference) voice.processReference(monoBuf, pwBuf, a1s, a2s, a3s, nb);
+                else             voice.process(monoBuf, pwBuf, a1s, a2s, a3s, nb);
+            } else {
+                if (poly) pool.skip(monoBuf, nb);
+                else      voice.skip(monoBuf, nb);
+                if (stereo) memset(sideBuf, 0, nb * sizeof(float));
+            }
+            STAGE_LAP(clock, STAGE_OSC);
+
+            // Mid/side → L/R in place: monoBuf = L, sideBuf = R
+            const float* inR = monoBuf;
+            if (stereo) {
+                for (int i = 0; i < nb; i++) {
+                    float m = monoBuf[i], s = sideBuf[i];
+                    monoBuf[i] = m + s;
+                    sideBuf[i] = m - s;
+                }
+                inR = sideBuf;
+            }
+
+            bool distIdle = voiceIdle && distActivity.idle();
+            float distPeak = 0.0f;
+            if (!distIdle) {
+                dist.process(monoBuf, nb);
+                distPeak = block_peak(monoBuf, nb);
+                if (stereo) {
+                    distR.process(sideBuf, nb);
+                    float pr = block_peak(sideBuf, nb);
+                    if (pr > distPeak) distPeak = pr;
+                }
+                distActivity.update(distPeak, nb);
+            }
+            STAGE_LAP(clock, STAGE_DIST);
+
+            bool reverbIdle = distIdle && reverbActivity.idle();
+            if (!reverbIdle) {
+                float tail;
+                if (fdnReverb) {
+                    fdn.process(monoBuf, inR, outLBuf, outRBuf, nb);
+                    tail = fdn.tailPeak;
+                } else if (reference && !stereo) {
+                    for (int i = 0; i < nb; i++)
+                        reverb.process(monoBuf[i], outLBuf[i], outRBuf[i]);
+                    tail = 1.0f;   // no comb level here: stays awake, never cleared
+                } else {
+                    reverb.process(monoBuf, inR, outLBuf, outRBuf, nb);
+                    tail = reverb.tailPeak;
+                }
+                float p = tail > distPeak ? tail : distPeak;
+                if (reverbActivity.update(p, nb)) {
+                    if (fdnReverb) fdn.clear();
+                    else           reverb.clear();
+                }
+            }
+            STAGE_LAP(clock, STAGE_REVERB);
+
+            float* dst = out + off * CHANNELS;
+            if (reverbIdle) {
+                memset(dst, 0, nb * CHANNELS * sizeof(float));
+                STAGE_LAP(clock, STAGE_OUTPUT);
+                continue;
+            }
+
+            // Volume, soft clip, peak tracking, interleave
+            for (int i = 0; i < nb; i++) {
+                float outL = outLBuf[i] * volBuf[i];
+                float outR = outRBuf[i] * volBuf[i];
+
+                // Soft clip
+                if (outL > 1.0f) outL = 1.0f;
+                else if (outL < -1.0f) outL = -1.0f;
+                if (outR > 1.0f) outR = 1.0f;
+                else if (outR < -1.0f) outR = -1.0f;
+
+                // Track peak level for VU (use louder channel)
+                float absL = fabsf(outL), absR = fabsf(outR);
+                float absS = absL > absR ? absL : absR;
+                if (absS > peakLevel) peakLevel = absS;
+
+                dst[i * 2]     = outL * MASTER_GAIN;  // L
+                dst[i * 2 + 1] = outR * MASTER_GAIN;  // R
+            }
+            STAGE_LAP(clock, STAGE_OUTPUT);
+        }
+    }
+};
+
+// ─── Response curves (uniformly sampled tables, built once) ─────────────────
+// A CurveTable holds f(0..N) at integer points: at() is an exact lookup for
+// integer inputs (10-bit knobs). Out-of-range inputs clamp to the ends.
+
+template <int N>
+struct CurveTable {
+    float y[N + 1];
+
+    template <typename F>
+    void build(F f) { for (int i = 0; i <= N; i++) y[i] = f(i); }
+
+    float at(int32_t i) const { return y[i < 0 ? 0 : (i > N ? N : i)]; }
+};
+
+static const int KNOB_MAX = 1023;   // /knobs values are 10-bit
+typedef CurveTable<KNOB_MAX> KnobCurve;
+
+// Every knob response, indexed by raw knob value. The coefficient curves
+// depend on the sample rate, so knob_curves() rebuilds them if it changed.
+struct KnobCurves {
+    float     rate = 0.0f;
+    KnobCurve ratio;          // K1, Ratio PWM: 1/16–8x
+    KnobCurve portaCoeff;     // K1: glide coefficient for 0–500 ms
+    KnobCurve lfoFreq;        // K1: PWM LFO Hz for the same period
+    KnobCurve cutoffHz;       // K2: 20 Hz–18 kHz
+    KnobCurve releaseMs;      // K4: 10–2000 ms (display)
+    KnobCurve releaseCoeff;   // K4: per-sample release multiplier
+
+    void build() {
+        rate = g_sampleRate;
+        ratio.build([](int k) { return 0.0625f * powf(128.0f, k / 1023.0f); });
+        portaCoeff.build([](int k) { return Portamento::coeffForMs(k * (500.0f / 1023.0f)); });
+        lfoFreq.build([](int k) { return TriLFO::freqForPeriodMs(k * (500.0f / 1023.0f)); });
+        cutoffHz.build([](int k) { return 20.0f * powf(900.0f, k / 1023.0f); });
+        releaseMs.build([](int k) { return 10.0f * powf(200.0f, k / 1023.0f); });
+        releaseCoeff.build([this](int k) { return Envelope::releaseCoeffForMs(releaseMs.y[k]); });
+    }
+};
+
+static const KnobCurves& knob_curves() {
+    static KnobCurves curves;
+    if (curves.rate != g_sampleRate) curves.build();
+    return curves;
+}
+
+// ─── Knob decoding (control side: table lookups, no libm) ───────────────────
+
+// Queues all KNOB_EVENTS, or nothing (returns false) when the ring is too
+// full to leave PARAM_NOTE_RESERVE; the display values are only updated
+// for a decode that went in.
+static bool knobs_to_events(ParamQueue& q, uint64_t t, int waveform,
+                            int32_t k1, int32_t k2, int32_t k3, int32_t k4, int32_t k5,
+                            float& dispPortoMs, float& dispRatio, float& dispCutoffHz,
+                            float& dispReso, float& dispReleaseMs) {
+    if (!knob_room(q)) return false;
+    const KnobCurves& c = knob_curves();
+
+    // K1: depends on waveform mode
+    if (waveform == 3) {
+        // Ratio PWM mode: K1 controls PWM ratio 0.0625–8.0 continuous
+        dispRatio = c.ratio.at(k1);
+        q.push({ParamEvent::PWM_RATIO, 0, dispRatio, 0.0f, t});
+    } else {
+        // Portamento 0–500ms linear (also sets PWM LFO rate)
+        dispPortoMs = k1 * (500.0f / 1023.0f);
+        q.push({ParamEvent::PORTA, 0, c.portaCoeff.at(k1), c.lfoFreq.at(k1), t});
+    }
+
+    // K2: Filter cutoff 20–18kHz exponential (target only, smoothed in audio loop)
+    dispCutoffHz = c.cutoffHz.at(k2);
+    q.push({ParamEvent::CUTOFF, 0, dispCutoffHz, 0.0f, t});
+
+    // K3: Filter resonance 0–0.95 (target only)
+    dispReso = k3 * (0.95f / 1023.0f);
+    q.push({ParamEvent::RESO, 0, dispReso, 0.0f, t});
+
+    // K4: Amp release 10–2000ms exponential
+    dispReleaseMs = c.releaseMs.at(k4);
+    q.push({ParamEvent::RELEASE, 0, c.releaseCoeff.at(k4), k4 / 1023.0f, t});
+
+    // K5: Master volume 0–1
+    q.push({ParamEvent::VOLUME, 0, k5 / 1023.0f, 0.0f, t});
+    return true;
+}
+
+// Preset → audio-side parameter set, through the same curves as the knobs
+static inline void decode_preset(const Preset& p, SynthPatch& out) {
+    const KnobCurves& c = knob_curves();
+    out.portaCoeff   = c.portaCoeff.at(p.porta);
+    out.lfoFreq      = c.lfoFreq.at(p.porta);
+    out.pwmRatio     = c.ratio.at(p.ratio);
+    out.cutoffHz     = c.cutoffHz.at(p.cutoff);
+    out.reso         = p.reso * (0.95f / 1023.0f);
+    out.releaseCoeff = c.releaseCoeff.at(p.release);
+    out.releaseNorm  = p.release / 1023.0f;
+    out.volume       = p.volume / 1023.0f;
+    out.waveform     = p.waveform % NUM_WAVEFORMS;
+    // ModMatrix::set ignores a bad slot, which would leave the routing from
+    // before the recall in place: decode one as the neutral depth-0 route
+    for (int k = 0; k < MOD_SLOTS; k++) {
+        bool ok = p.modSource[k] < MOD_SOURCES && p.modDest[k] < MOD_DESTS
+               && fabsf(p.modDepth[k]) < 1e6f;
+        out.modSource[k] = ok ? p.modSource[k] : (uint8_t)MOD_SRC_LFO;
+        out.modDest[k]   = ok ? p.modDest[k]   : (uint8_t)MOD_DST_PW;
+        out.modDepth[k]  = ok ? p.modDepth[k]  : 0.0f;
+    }
+}
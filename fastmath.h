@@ -0,0 +1,84 @@
+// fastmath.h — polynomial/rational approximations for the per-sample hot path
+// Header-only. Error bounds below were measured against double-precision libm
+// evaluated at the same float input, over the stated ranges (no FMA).
+//
+// The "lite" DSP profile (make PROFILE=lite → MONOSYNTH_LITE) routes the
+// dsp_* wrappers to these; the default profile keeps libm.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// tanh: [7/6] Padé, clamped to ±1 for |x| > 4.97 (the clamp point that
+// minimises the worst case). Max abs error 1e-4 at the clamp, 2e-7 for |x| < 2.
+static inline float fast_tanh(float x) {
+    if (x >  4.97f) return  1.0f;
+    if (x < -4.97f) return -1.0f;
+    float x2 = x * x;
+    float num = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
+    float den = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));
+    return num / den;
+}
+
+// exp2: round-to-nearest split, degree-6 Taylor on [-0.5, 0.5], exponent
+// assembled from bits. Max rel error 2.2e-7 over [-126, 126].
+static inline float fast_exp2(float x) {
+    if (x < -126.0f) x = -126.0f;
+    if (x >  126.0f) x =  126.0f;
+    float xi = floorf(x + 0.5f);
+    float f  = x - xi;
+    float p = 1.0f + f * (0.69314718f + f * (0.24022651f + f * (0.05550411f
+            + f * (0.00961813f + f * (0.00133336f + f * 0.00015404f)))));
+    uint32_t bits = (uint32_t)((int32_t)xi + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+// sin on [-π/2, π/2]: odd degree-11 Taylor. Max abs error 2.2e-7.
+static inline float fast_sin_hp(float x) {
+    float x2 = x * x;
+    return x * (1.0f + x2 * (-1.6666667e-1f + x2 * (8.3333333e-3f + x2 * (-1.9841270e-4f
+             + x2 * (2.7557319e-6f + x2 * -2.5052108e-8f)))));
+}
+
+// cos on [-π/2, π/2]: even degree-12 Taylor (truncation error 6e-9).
+static inline float fast_cos_hp(float x) {
+    float x2 = x * x;
+    return 1.0f + x2 * (-0.5f + x2 * (4.1666667e-2f + x2 * (-1.3888889e-3f
+         + x2 * (2.4801587e-5f + x2 * (-2.7557319e-7f + x2 * 2.0876757e-9f)))));
+}
+
+// sin for any finite x: reduce to [-π, π], fold to [-π/2, π/2].
+// Max abs error 2.2e-7 for |x| ≤ 2π (reduction error grows with |x|).
+static inline float fast_sin(float x) {
+    const float PI_F     = 3.14159265f;
+    const float HALF_PI  = 1.57079633f;
+    const float INV_2PI  = 0.15915494f;
+    x -= 6.28318531f * floorf(x * INV_2PI + 0.5f);
+    if (x >  HALF_PI) x =  PI_F - x;
+    if (x < -HALF_PI) x = -PI_F - x;
+    return fast_sin_hp(x);
+}
+
+// tan on [0, 1.45] (covers π·fc/fs up to fc = 20 kHz at 44.1 kHz):
+// sin/cos quotient. Max rel error 9e-7 (libm tanf: 5e-7).
+static inline float fast_tan(float x) {
+    return fast_sin_hp(x) / fast_cos_hp(x);
+}
+
+// ─── Profile selection ───────────────────────────────────────────────────────
+
+#ifdef MONOSYNTH_LITE
+static inline float dsp_tanh(float x) { return fast_tanh(x); }
+static inline float dsp_exp2(float x) { return fast_exp2(x); }
+static inline float dsp_sin(float x)  { return fast_sin(x); }
+static inline float dsp_tan(float x)  { return fast_tan(x); }
+#else
+static inline float dsp_tanh(float x) { return tanhf(x); }
+static inline float dsp_exp2(float x) { return exp2f(x); }
+static inline float dsp_sin(float x)  { return sinf(x); }
+static inline float dsp_tan(float x)  { return tanf(x); }
+#endif
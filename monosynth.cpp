@@ -1,609 +1,1129 @@
-// CppMonoSynth — single-file C++ monosynth for Critter & Guitari Organelle
+// CppMonoSynth — C++ monosynth for Critter & Guitari Organelle (DSP engine in dsp.h)
 // PolyBLEP multi-waveform → Cytomic SVF LPF → AR envelope → ALSA hw:0
 // OSC control via UDP port 4000
 
 #include <alsa/asoundlib.h>
 #include <arpa/inet.h>
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <cerrno>
+#include <cstdarg>
 #include <csignal>
 #include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
 #include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "dsp.h"
 
 // ─── Constants ───────────────────────────────────────────────────────────────
 
-static constexpr int    SAMPLE_RATE         = 44100;
-static constexpr int    PERIOD_FRAMES       = 128;
-static constexpr int    CHANNELS            = 2;
 static constexpr int    OSC_PORT            = 4000;
 static constexpr int    MOTHER_PORT         = 4001;
-static constexpr int    NOTE_STACK_SZ       = 16;
-static constexpr float  TWO_PI              = 6.283185307f;
-static constexpr float  PI                  = 3.141592654f;
-static constexpr float  INV_SR              = 1.0f / SAMPLE_RATE;
-static constexpr float  ATTACK_MS           = 5.0f;
-static constexpr int    NUM_WAVEFORMS       = 4;
-static constexpr int    OLED_INTERVAL       = 2205;  // ~50ms at 44100Hz
-static constexpr float  PARAM_SMOOTH_COEFF = 0.002f;
-static constexpr float  MASTER_GAIN        = 0.35f;   // match Pd patch output level
+static constexpr int    OLED_INTERVAL_MS    = 50;
+static constexpr int    AUDIO_RT_PRIORITY   = 70;    // SCHED_FIFO
+static constexpr int    STATS_INTERVAL_MS   = 1000;  // /stats publish period
+static constexpr float  LOAD_SMOOTH_COEFF   = 0.01f; // per-period EMA (~0.3 s)
+static constexpr int    MIN_PERIOD_FRAMES   = 16;
+static constexpr int    AUTOTUNE_START_FRAMES = 32;  // --autotune first try
+static constexpr int    AUTOTUNE_GRACE_MS   = 250;   // start-up xruns ignored after (re)configure
+static constexpr int    AUTOTUNE_STABLE_MS  = 5000;  // xrun-free run that ends tuning
+static constexpr int    LATENCY_SHOW_MS     = 4000;  // OLED latency report once tuned
+static constexpr int    NOTICE_SHOW_MS      = 2000;  // OLED line 5 preset messages
+static constexpr int    PICKUP_WINDOW       = 16;    // knob counts that count as "at" a value
+static constexpr int    INIT_RETRY_MS       = 20;    // bind / PCM open poll interval
+static constexpr int    INIT_TIMEOUT_MS     = 5000;  // give up on bind / PCM open after this
+static constexpr int    INIT_REPORT_MS      = 500;   // OLED retry message interval
+static constexpr int    REC_RING_SAMPLES    = 1 << 19;   // 2 MB of float: ~5.9 s stereo at 44.1 kHz
+static constexpr int    REC_CHUNK_BYTES     = 64 * 1024; // one write() to the USB drive
+// Data bytes per file: the RIFF sizes are 32-bit (and FAT32 stops at 4 GiB - 1),
+// so a longer take continues in the next file
+static constexpr uint32_t REC_MAX_DATA_BYTES  = 0xFFFFFFFFu - (REC_CHUNK_BYTES - 1);
+static constexpr int    REC_POLL_MS         = 20;    // writer wake-up (ring holds seconds)
+static constexpr int    REC_NICE            = 10;    // writer thread priority
 
 static const int   LED_COLORS[] = {1, 2, 3, 4};  // Red, Yellow, Green, Cyan
 
 static volatile sig_atomic_t g_running = 1;
+static std::atomic<int> g_audioError{0};   // set by the audio thread on fatal PCM error
 
 static void sig_handler(int) { g_running = 0; }
 
-// ─── PolyBLEP residual ──────────────────────────────────────────────────────
+#if MONOSYNTH_PROBES
+static volatile sig_atomic_t g_probeDump = 0;   // SIGUSR1: print the probe table
+static void probe_sig_handler(int) { g_probeDump = 1; }
+#endif
 
-static inline float polyblep(float phase, float dt) {
-    if (phase < dt) {
-        float t = phase / dt;
-        return t + t - t * t - 1.0f;
-    }
-    if (phase > 1.0f - dt) {
-        float t = (phase - 1.0f) / dt;
-        return t * t + t + t + 1.0f;
-    }
-    return 0.0f;
+// ─── OSC helpers ─────────────────────────────────────────────────────────────
+
+// Round up to next multiple of 4
+static inline int osc_pad(int n) { return (n + 3) & ~3; }
+
+// Parse an int32 from OSC data (big-endian)
+static inline int32_t osc_int(const uint8_t* p) {
+    return (int32_t)ntohl(*(const uint32_t*)p);
 }
 
-// ─── Oscillator ──────────────────────────────────────────────────────────────
-
-struct Oscillator {
-    float phase = 0.0f;
-    float freq  = 440.0f;
-    float pulseWidth = 0.5f;
-    float pwmPhase = 0.0f;
-    float pwmRatio = 1.0f;
-
-    void advance() {
-        phase += freq * INV_SR;
-        if (phase >= 1.0f) phase -= 1.0f;
-        pwmPhase += freq * pwmRatio * INV_SR;
-        if (pwmPhase >= 1.0f) pwmPhase -= floorf(pwmPhase);
-    }
-
-    float saw() const {
-        float dt = freq * INV_SR;
-        float s = 2.0f * phase - 1.0f;
-        s -= polyblep(phase, dt);
-        return s;
-    }
-
-    float pulse() const {
-        float dt = freq * INV_SR;
-        float s = (phase < pulseWidth) ? 1.0f : -1.0f;
-        s += polyblep(phase, dt);          // rising edge at phase=0
-        float shifted = phase - pulseWidth;
-        if (shifted < 0.0f) shifted += 1.0f;
-        s -= polyblep(shifted, dt);        // falling edge at phase=pw
-        return s;
-    }
-
-    float triangle() const {
-        return (phase < 0.5f) ? (4.0f * phase - 1.0f) : (3.0f - 4.0f * phase);
-    }
-
-    float ratioPulse() const {
-        float pw = 0.5f + 0.4f * sinf(TWO_PI * pwmPhase);
-        float dt = freq * INV_SR;
-        float s = (phase < pw) ? 1.0f : -1.0f;
-        s += polyblep(phase, dt);
-        float shifted = phase - pw;
-        if (shifted < 0.0f) shifted += 1.0f;
-        s -= polyblep(shifted, dt);
-        return s;
-    }
-
-    float waveform(int idx) const {
-        switch (idx) {
-        case 0: return saw();
-        case 1: return pulse();
-        case 2: return triangle();
-        case 3: return ratioPulse();
-        default: return saw();
-        }
-    }
-};
+// Numeric argument by type tag: 'i' or 'f' (Pd sends floats by default)
+static inline float osc_num(const uint8_t* p, char tag) {
+    int32_t v = osc_int(p);
+    if (tag != 'f') return (float)v;
+    float f;
+    memcpy(&f, &v, sizeof(f));
+    return f;
+}
 
-// ─── Portamento (one-pole in log2-freq domain) ───────────────────────────────
+// ─── OSC display transport (pre-encoded messages to mother on port 4001) ────
 
-struct Portamento {
-    float target   = 0.0f;   // log2(freq)
-    float current  = 0.0f;   // log2(freq)
-    float coeff    = 1.0f;   // 1.0 = instant
+static constexpr int OSC_MSG_MAX   = 128;   // longest message: /stats or one OLED line
+static constexpr int OSC_BATCH_MAX = 16;    // messages per control-loop flush
 
-    void setTime(float ms) {
-        if (ms < 1.0f) { coeff = 1.0f; return; }
-        float samples = ms * 0.001f * SAMPLE_RATE;
-        coeff = 1.0f - expf(-1.0f / samples);
+// Address and type tag are laid out once; sends only patch the arguments.
+// Int arguments live in fixed 4-byte slots; a string message carries one
+// string as its last argument, so only the length changes.
+struct OscMsg {
+    uint8_t buf[OSC_MSG_MAX];
+    int     argOff = 0;   // first argument byte
+    int     len    = 0;   // encoded size with the current arguments (0 = invalid)
+
+    void init(const char* path, const char* types) {
+        memset(buf, 0, sizeof(buf));
+        int plen = (int)strlen(path), tlen = (int)strlen(types);
+        argOff = osc_pad(plen + 1) + osc_pad(tlen + 2);   // ',' + types + null
+        len = argOff + 4 * tlen;                          // ints, or an empty string
+        if (len > OSC_MSG_MAX) { len = 0; return; }
+        memcpy(buf, path, plen);
+        buf[osc_pad(plen + 1)] = ',';
+        memcpy(buf + osc_pad(plen + 1) + 1, types, tlen);
     }
 
-    void setTarget(float freqHz) {
-        target = log2f(freqHz);
+    void setInt(int slot, int32_t v) {
+        uint32_t nv = htonl((uint32_t)v);
+        memcpy(buf + argOff + 4 * slot, &nv, 4);
     }
 
-    void snap(float freqHz) {
-        target  = log2f(freqHz);
-        current = target;
+    // Truncates to fit; OSC_MSG_MAX and argOff are 4-aligned, so padding does too
+    void setStr(const char* s) {
+        int n = (int)strnlen(s, OSC_MSG_MAX - argOff - 1);
+        int end = argOff + osc_pad(n + 1);
+        memcpy(buf + argOff, s, n);
+        memset(buf + argOff + n, 0, end - argOff - n);
+        len = end;
     }
 
-    float tick() {
-        current += coeff * (target - current);
-        return exp2f(current);
+    void send(int sock, const struct sockaddr_in* addr) const {
+        if (len) sendto(sock, buf, len, 0, (const struct sockaddr*)addr, sizeof(*addr));
     }
 };
 
-// ─── Triangle LFO (for PWM modulation, tied to portamento time) ─────────────
+// One control-loop iteration's messages, sent with a single sendmmsg (or, with
+// bundle set, one sendto of an OSC #bundle). Holds pointers, not copies: add a
+// template at most once per flush and don't patch it again before flushing.
+struct OscBatch {
+    const OscMsg* msgs[OSC_BATCH_MAX];
+    int  count  = 0;
+    bool bundle = false;
 
-struct TriLFO {
-    float phase = 0.0f;
-    float freq  = 0.0f;
-
-    void setPeriodMs(float ms) {
-        freq = (ms < 1.0f) ? 0.0f : 1000.0f / ms;
+    void add(const OscMsg& m) {
+        if (m.len && count < OSC_BATCH_MAX) msgs[count++] = &m;
     }
 
-    float tick() {
-        if (freq <= 0.0f) return 0.0f;
-        phase += freq * INV_SR;
-        if (phase >= 1.0f) phase -= 1.0f;
-        return (phase < 0.5f) ? (4.0f * phase - 1.0f) : (3.0f - 4.0f * phase);
+    void flush(int sock, const struct sockaddr_in* addr) {
+        if (count == 0) return;
+        if (bundle) {
+            // "#bundle", timetag 1 (= immediately), then size-prefixed elements
+            uint8_t b[16 + OSC_BATCH_MAX * (4 + OSC_MSG_MAX)];
+            memcpy(b, "#bundle\0\0\0\0\0\0\0\0\1", 16);
+            int off = 16;
+            for (int i = 0; i < count; i++) {
+                uint32_t nv = htonl((uint32_t)msgs[i]->len);
+                memcpy(b + off, &nv, 4);
+                memcpy(b + off + 4, msgs[i]->buf, msgs[i]->len);
+                off += 4 + msgs[i]->len;
+            }
+            sendto(sock, b, off, 0, (const struct sockaddr*)addr, sizeof(*addr));
+        } else {
+            struct mmsghdr hdr[OSC_BATCH_MAX];
+            struct iovec   iov[OSC_BATCH_MAX];
+            memset(hdr, 0, sizeof(hdr[0]) * count);
+            for (int i = 0; i < count; i++) {
+                iov[i].iov_base = (void*)msgs[i]->buf;
+                iov[i].iov_len  = (size_t)msgs[i]->len;
+                hdr[i].msg_hdr.msg_name    = (void*)addr;
+                hdr[i].msg_hdr.msg_namelen = sizeof(*addr);
+                hdr[i].msg_hdr.msg_iov     = &iov[i];
+                hdr[i].msg_hdr.msg_iovlen  = 1;
+            }
+            sendmmsg(sock, hdr, count, 0);
+        }
+        count = 0;
     }
 };
 
-// ─── Cytomic SVF (trapezoidal integration, unconditionally stable) ───────────
-
-struct SVFilter {
-    float ic1eq = 0.0f;
-    float ic2eq = 0.0f;
-    float g     = 0.0f;
-    float k     = 2.0f;   // k = 2 - 2*reso
-    float a1    = 0.0f;
-    float a2    = 0.0f;
-    float a3    = 0.0f;
-
-    void setParams(float cutoffHz, float reso) {
-        float fc = cutoffHz;
-        if (fc < 20.0f)    fc = 20.0f;
-        if (fc > 20000.0f) fc = 20000.0f;
-        g  = tanf(PI * fc * INV_SR);
-        k  = 2.0f - 2.0f * reso;
-        a1 = 1.0f / (1.0f + g * (g + k));
-        a2 = g * a1;
-        a3 = g * a2;
-    }
-
-    // Returns low-pass output
-    float tick(float v0) {
-        float v3 = v0 - ic2eq;
-        float v1 = a1 * ic1eq + a2 * v3;
-        float v2 = ic2eq + a2 * ic1eq + a3 * v3;
-        ic1eq = 2.0f * v1 - ic1eq;
-        ic2eq = 2.0f * v2 - ic2eq;
-        return v2;
-    }
-};
+// One-off sends (startup progress, errors)
+static void osc_send_str(int sock, struct sockaddr_in* addr,
+                          const char* path, const char* text) {
+    OscMsg m;
+    m.init(path, "s");
+    m.setStr(text);
+    m.send(sock, addr);
+}
+
+static void osc_send_1i(int sock, struct sockaddr_in* addr,
+                         const char* path, int v0) {
+    OscMsg m;
+    m.init(path, "i");
+    m.setInt(0, v0);
+    m.send(sock, addr);
+}
 
-// ─── AR Envelope ─────────────────────────────────────────────────────────────
+// ─── OLED display model (shadow of mother's screen, dirty regions) ─────────
+// The 128x64 screen as the patch uses it: five text rows (/oled/line/N, the
+// smallest text region mother redraws) and the VU bar, a box at the bottom.
+// `shown` is what mother has, `want` what the next frame should show; a
+// flush sends only regions that differ, at most `budget` packets a frame,
+// round-robin so a busy row cannot starve the others. A row's text is only
+// re-formatted when its input key changes; the VU bar moves by delta boxes
+// (fill the gained span, clear the lost one) instead of clear + redraw.
+
+static constexpr int OLED_ROWS         = 5;
+static constexpr int OLED_COLS         = 21;    // 6-px cells on a 128-px row
+static constexpr int OLED_FRAME_BUDGET = 4;     // display packets per OLED frame
+static constexpr int VU_X0 = 3, VU_Y0 = 55, VU_X1 = 125, VU_Y1 = 62;
+static constexpr int VU_MAX = VU_X1 - VU_X0;    // widest bar, columns past VU_X0
+
+static inline uint32_t oled_bits(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
 
-struct Envelope {
-    enum Stage { OFF, ATTACK, RELEASE };
-    Stage stage       = OFF;
-    float value       = 0.0f;
-    float attackCoeff = 0.0f;
-    float releaseCoeff= 0.0f;
+static inline uint32_t oled_hash(const char* s) {   // FNV-1a
+    uint32_t h = 2166136261u;
+    while (*s) h = (h ^ (uint8_t)*s++) * 16777619u;
+    return h;
+}
 
-    Envelope() {
-        setAttack(ATTACK_MS);
-        setRelease(200.0f);
-    }
+struct OledView {
+    static constexpr int REGIONS = OLED_ROWS + 1;   // rows, then the VU bar
 
-    void setAttack(float ms) {
-        float samples = ms * 0.001f * SAMPLE_RATE;
-        attackCoeff = 1.0f - expf(-1.0f / samples);
-    }
+    char     shown[OLED_ROWS][OLED_COLS + 1] = {};
+    char     want[OLED_ROWS][OLED_COLS + 1]  = {};
+    uint64_t key[OLED_ROWS] = {};        // displayed values, packed
+    int      variant[OLED_ROWS];         // which format they went through (-1 = none)
+    bool     rowKnown[OLED_ROWS] = {};   // false: mother's row is unknown, send once
+    int      vuShown = 0, vuWant = 0;
+    bool     vuKnown = false;            // false: clear the whole bar first
+    int      budget  = OLED_FRAME_BUDGET;
+    int      cursor  = 0;                // first region the next flush looks at
+    uint32_t deferred = 0;               // region sends pushed to a later frame
 
-    void setRelease(float ms) {
-        if (ms < 1.0f) ms = 1.0f;
-        float samples = ms * 0.001f * SAMPLE_RATE;
-        releaseCoeff = expf(-1.0f / samples);
-    }
+    OscMsg rowMsg[OLED_ROWS], vuDelta, vuClear;
 
-    void gate(bool on) {
-        if (on) stage = ATTACK;
-        else if (stage == ATTACK) stage = RELEASE;
+    void init() {
+        for (int i = 0; i < OLED_ROWS; i++) variant[i] = -1;
+        for (int i = 0; i < OLED_ROWS; i++) {
+            char path[16];
+            snprintf(path, sizeof(path), "/oled/line/%d", i + 1);
+            rowMsg[i].init(path, "s");
+        }
+        vuDelta.init("/oled/gBox", "iiiii");   // x1 y1 x2 y2 fill
+        vuClear.init("/oled/gBox", "iiiii");
+        const int32_t box[] = {VU_X0, VU_Y0, VU_X1, VU_Y1, 0};
+        for (int j = 0; j < 5; j++) { vuDelta.setInt(j, box[j]); vuClear.setInt(j, box[j]); }
     }
 
-    float tick() {
-        switch (stage) {
-        case ATTACK:
-            value += attackCoeff * (1.0f - value);
-            if (value > 0.999f) { value = 1.0f; }
-            break;
-        case RELEASE:
-            value *= releaseCoeff;
-            if (value < 0.0001f) { value = 0.0f; stage = OFF; }
-            break;
-        case OFF:
-            break;
-        }
-        return value;
+    // Format row i only if its format variant or either input changed
+    void row(int i, int v, uint32_t a, uint32_t b, const char* fmt, ...)
+        __attribute__((format(printf, 6, 7))) {
+        uint64_t k = (uint64_t)a << 32 | b;
+        if (variant[i] == v && key[i] == k) return;
+        variant[i] = v;
+        key[i] = k;
+        va_list ap;
+        va_start(ap, fmt);
+        vsnprintf(want[i], sizeof(want[i]), fmt, ap);
+        va_end(ap);
     }
-};
 
-// ─── Note Stack (last-note priority) ─────────────────────────────────────────
+    void vu(float peak) {
+        int w = (int)(peak * VU_MAX);
+        vuWant = w > VU_MAX ? VU_MAX : (w < 0 ? 0 : w);
+    }
 
-struct NoteStack {
-    int notes[NOTE_STACK_SZ];
-    int size = 0;
+    bool dirty(int r) const {
+        if (r < OLED_ROWS) return !rowKnown[r] || strcmp(shown[r], want[r]) != 0;
+        return !vuKnown || vuShown != vuWant;
+    }
 
-    void push(int note) {
-        // Remove if already present
-        remove(note);
-        if (size < NOTE_STACK_SZ) {
-            notes[size++] = note;
+    // Columns VU_X0..VU_X0+w are lit for w > 0; none for w = 0
+    void vuStep(OscBatch& batch) {
+        if (!vuKnown) {
+            batch.add(vuClear);
+            vuShown = 0;
+            vuKnown = true;
+            return;   // the bar itself goes next frame (one vuDelta per flush)
         }
+        int a = vuShown, b = vuWant;
+        bool grow = b > a;
+        int lo = grow ? a : b, hi = grow ? b : a;
+        vuDelta.setInt(0, lo > 0 ? VU_X0 + lo + 1 : VU_X0);
+        vuDelta.setInt(2, VU_X0 + hi);
+        vuDelta.setInt(4, grow ? 1 : 0);
+        batch.add(vuDelta);
+        vuShown = b;
     }
 
-    void remove(int note) {
-        for (int i = 0; i < size; i++) {
-            if (notes[i] == note) {
-                for (int j = i; j < size - 1; j++)
-                    notes[j] = notes[j + 1];
-                size--;
-                return;
+    // Queue this frame's changes; returns packets added
+    int flush(OscBatch& batch) {
+        int sent = 0;
+        for (int n = 0; n < REGIONS; n++) {
+            int r = (cursor + n) % REGIONS;
+            if (!dirty(r)) continue;
+            if (sent == budget) {
+                deferred++;
+                cursor = r;   // resume here next frame
+                return sent;
+            }
+            if (r < OLED_ROWS) {
+                rowMsg[r].setStr(want[r]);
+                batch.add(rowMsg[r]);
+                memcpy(shown[r], want[r], sizeof(shown[r]));
+                rowKnown[r] = true;
+            } else {
+                vuStep(batch);
             }
+            sent++;
         }
+        cursor = (cursor + 1) % REGIONS;
+        return sent;
     }
-
-    int top() const { return size > 0 ? notes[size - 1] : -1; }
-    bool empty() const { return size == 0; }
 };
 
-// ─── Note Tracker (speed/length dynamics from play style) ───────────────────
-
-struct NoteTracker {
-    uint64_t sampleCounter    = 0;
-    uint64_t lastNoteOnSample = 0;
-    float    avgIntervalSamples = 44100.0f;  // 1 second default
-    float    speed            = 0.0f;        // 0=slow, 1=fast
-    float    length           = 0.0f;        // 0=short, 1=long
-
-    // Ring buffer of last 3 note durations
-    float    durations[3]     = {44100.0f, 44100.0f, 44100.0f};
-    int      durIdx           = 0;
-    float    avgDuration      = 44100.0f;
-
-    // One-pole smoothing (~2.3s time constant at 44100 Hz)
-    static constexpr float SMOOTH = 1e-5f;
+// ─── ALSA output (mmap zero-copy, RW interleaved fallback) ──────────────────
 
-    // Thresholds in samples
-    static constexpr float FAST_INTERVAL  = 2205.0f;   // 50ms
-    static constexpr float SLOW_INTERVAL  = 44100.0f;  // 1000ms
-    static constexpr float SHORT_DUR      = 2205.0f;   // 50ms
-    static constexpr float LONG_DUR       = 88200.0f;  // 2000ms
+// Preferred device formats, best first (float/S32 skip a plug-layer conversion
+// on codecs that are natively 24/32-bit)
+static const snd_pcm_format_t ALSA_FORMATS[] = {
+    SND_PCM_FORMAT_FLOAT_LE, SND_PCM_FORMAT_S32_LE, SND_PCM_FORMAT_S24_LE, SND_PCM_FORMAT_S16_LE
+};
+static const SampleFormat ALSA_FORMAT_MAP[] = {FMT_FLOAT, FMT_S32, FMT_S24, FMT_S16};
+
+struct AudioOut {
+    snd_pcm_t*        pcm     = nullptr;
+    bool              mmap    = false;
+    uint8_t*          staging = nullptr;   // RW mode render target
+    SampleFormat      format  = FMT_S16;
+    unsigned int      rate    = SAMPLE_RATE;   // granted by the device
+    snd_pcm_uframes_t mmapOffset = 0;
+    snd_pcm_uframes_t period  = PERIOD_FRAMES;
+    snd_pcm_uframes_t bufsize = 0;
+    snd_pcm_uframes_t periods = 2;         // buffer = periods × period
+    snd_pcm_access_t  access  = SND_PCM_ACCESS_MMAP_INTERLEAVED;
+    std::atomic<uint32_t> xruns{0};        // underruns/suspends recovered so far
+    std::atomic<bool>     tuning{false};   // auto-tune still backing off (audio thread clears)
+
+    int configure(snd_pcm_access_t acc, snd_pcm_uframes_t req, snd_pcm_uframes_t nper,
+                  unsigned int wantRate = SAMPLE_RATE) {
+        snd_pcm_hw_params_t* hw_params;
+        snd_pcm_hw_params_alloca(&hw_params);
+        snd_pcm_hw_params_any(pcm, hw_params);
+        int err = snd_pcm_hw_params_set_access(pcm, hw_params, acc);
+        if (err < 0) return err;
+        err = -EINVAL;
+        for (size_t f = 0; f < sizeof(ALSA_FORMATS) / sizeof(ALSA_FORMATS[0]); f++) {
+            if (snd_pcm_hw_params_test_format(pcm, hw_params, ALSA_FORMATS[f]) == 0) {
+                err = snd_pcm_hw_params_set_format(pcm, hw_params, ALSA_FORMATS[f]);
+                format = ALSA_FORMAT_MAP[f];
+                break;
+            }
+        }
+        if (err < 0) return err;
+        snd_pcm_hw_params_set_channels(pcm, hw_params, CHANNELS);
+        // Take whatever rate the device grants, with plughw's resampler off
+        // so that is the native rate; the DSP adapts to it
+        snd_pcm_hw_params_set_rate_resample(pcm, hw_params, 0);
+        rate = wantRate;
+        snd_pcm_hw_params_set_rate_near(pcm, hw_params, &rate, nullptr);
+        // Cap the period first so _near can't round past the render buffers
+        snd_pcm_uframes_t maxPeriod = MAX_PERIOD_FRAMES;
+        snd_pcm_hw_params_set_period_size_max(pcm, hw_params, &maxPeriod, nullptr);
+        period = req;
+        snd_pcm_hw_params_set_period_size_near(pcm, hw_params, &period, nullptr);
+        if (period > (snd_pcm_uframes_t)MAX_PERIOD_FRAMES) return -EINVAL;
+        bufsize = period * nper;
+        snd_pcm_hw_params_set_buffer_size_near(pcm, hw_params, &bufsize);
+        err = snd_pcm_hw_params(pcm, hw_params);
+        if (err < 0) return err;
+        access  = acc;
+        periods = nper;
+        mmap = (acc == SND_PCM_ACCESS_MMAP_INTERLEAVED);
+        return snd_pcm_prepare(pcm);
+    }
 
-    void noteOn() {
-        uint64_t now = sampleCounter;
-        uint64_t interval = now - lastNoteOnSample;
-        lastNoteOnSample = now;
-        // Smooth the interval (exponential moving average)
-        if (interval < (uint64_t)(SLOW_INTERVAL * 4))  // ignore huge gaps
-            avgIntervalSamples += 0.3f * ((float)interval - avgIntervalSamples);
+    // Stop and renegotiate at a new period, same access, buffer ratio and
+    // rate (auto-tune back-off; audio thread only). The DSP was set up for
+    // the current rate, so a device that won't keep it counts as refusing
+    // the period. Returns 0 on the new period, 1 if it was refused and the
+    // last good one restored, <0 if even the restore failed (fatal).
+    int reconfigure(snd_pcm_uframes_t req) {
+        const snd_pcm_uframes_t was = period;
+        const unsigned int      hz  = rate;
+        snd_pcm_drop(pcm);
+        if (configure(access, req, periods, hz) == 0 && rate == hz) return 0;
+        int err = configure(access, was, periods, hz);
+        if (err < 0) return err;
+        return rate == hz ? 1 : -EINVAL;
     }
 
-    void noteOff() {
-        uint64_t dur = sampleCounter - lastNoteOnSample;
-        durations[durIdx] = (float)dur;
-        durIdx = (durIdx + 1) % 3;
-        avgDuration = (durations[0] + durations[1] + durations[2]) / 3.0f;
+    // Key-to-sound: one period of event scheduling plus the queued buffer
+    float latencyMs() const { return 1000.0f * (float)(period + bufsize) / (float)rate; }
+
+    // Returns 0 after a successful recovery (caller retries), <0 if fatal
+    int recover(int err) {
+        if (err == -EPIPE || err == -ESTRPIPE)
+            xruns.store(xruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        err = snd_pcm_recover(pcm, err, 0);
+        return err < 0 ? err : 0;
     }
 
-    void tick() {
-        sampleCounter++;
+    // Contiguous writable frames (≤ want) at *dst; 0 = waited/recovered, retry
+    snd_pcm_sframes_t begin(uint8_t** dst, snd_pcm_uframes_t want) {
+        if (!mmap) { *dst = staging; return (snd_pcm_sframes_t)want; }
+
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm);
+        if (avail < 0) return recover((int)avail);
+        if ((snd_pcm_uframes_t)avail < want) {
+            // Ring full: kick off a prepared stream, else sleep until a period frees
+            int err = (snd_pcm_state(pcm) == SND_PCM_STATE_PREPARED)
+                    ? snd_pcm_start(pcm) : snd_pcm_wait(pcm, 1000);
+            return err < 0 ? recover(err) : 0;
+        }
 
-        // Map interval → speed: fast (small interval) = 1, slow = 0
-        float rawSpeed = 1.0f - (avgIntervalSamples - FAST_INTERVAL) / (SLOW_INTERVAL - FAST_INTERVAL);
-        if (rawSpeed < 0.0f) rawSpeed = 0.0f;
-        if (rawSpeed > 1.0f) rawSpeed = 1.0f;
-        speed += SMOOTH * (rawSpeed - speed);
+        const snd_pcm_channel_area_t* areas;
+        snd_pcm_uframes_t frames = want;
+        int err = snd_pcm_mmap_begin(pcm, &areas, &mmapOffset, &frames);
+        if (err < 0) return recover(err);
+        // Interleaved: both channels share one area, step = one frame
+        *dst = (uint8_t*)areas[0].addr + areas[0].first / 8
+             + mmapOffset * (areas[0].step / 8);
+        return (snd_pcm_sframes_t)frames;
+    }
 
-        // Map duration → length: long = 1, short = 0
-        float rawLength = (avgDuration - SHORT_DUR) / (LONG_DUR - SHORT_DUR);
-        if (rawLength < 0.0f) rawLength = 0.0f;
-        if (rawLength > 1.0f) rawLength = 1.0f;
-        length += SMOOTH * (rawLength - length);
+    snd_pcm_sframes_t commit(snd_pcm_uframes_t frames) {
+        if (!mmap) {
+            snd_pcm_sframes_t r = snd_pcm_writei(pcm, staging, frames);
+            return r < 0 ? recover((int)r) : r;   // EPIPE = underrun
+        }
+        snd_pcm_sframes_t r = snd_pcm_mmap_commit(pcm, mmapOffset, frames);
+        if (r < 0) return recover((int)r);
+        if ((snd_pcm_uframes_t)r != frames) return recover(-EPIPE);
+        return r;
     }
 };
 
-// ─── Distortion (tanh waveshaper) ───────────────────────────────────────────
+// ─── Audio thread (SCHED_FIFO; PCM I/O is its only syscall) ─────────────────
 
-struct Distortion {
-    float drive  = 1.0f;
-    float dryWet = 0.0f;
-    float amount = 0.0f;
+// Render time as % of the period deadline: bin i counts periods below
+// LOAD_HIST_EDGES[i]; the last bin counts deadline misses (≥ 100%)
+static const int LOAD_HIST_EDGES[] = {10, 25, 50, 75, 90, 100};
+static constexpr int LOAD_HIST_BINS = sizeof(LOAD_HIST_EDGES) / sizeof(LOAD_HIST_EDGES[0]) + 1;
 
-    void updateFromDynamics(float speed, float releaseNorm) {
-        amount = speed * (0.3f + 0.7f * (1.0f - releaseNorm));
-        drive  = 1.0f + amount * 15.0f;
-        dryWet = amount;
-    }
+// Cumulative; written only by the audio thread, read by control for /stats
+struct LoadHistogram {
+    std::atomic<uint32_t> bins[LOAD_HIST_BINS];
+    std::atomic<uint32_t> worstNs{0};
+
+    LoadHistogram() { for (auto& b : bins) b.store(0); }
 
-    float process(float in) {
-        float boosted = in * (1.0f + amount * 0.5f);
-        float wet = tanhf(boosted * drive) / tanhf(drive);
-        return in + dryWet * (wet - in);
+    void add(uint32_t ns, uint32_t deadlineNs) {
+        uint32_t pct = (uint32_t)((uint64_t)ns * 100 / deadlineNs);
+        int i = 0;
+        while (i < LOAD_HIST_BINS - 1 && pct >= (uint32_t)LOAD_HIST_EDGES[i]) i++;
+        bins[i].store(bins[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (ns > worstNs.load(std::memory_order_relaxed))
+            worstNs.store(ns, std::memory_order_relaxed);
     }
 };
 
-// ─── LP-Comb filter (for Schroeder reverb) ──────────────────────────────────
-
-struct LPComb {
-    float  buf[4096];
-    int    size    = 0;
-    int    idx     = 0;
-    float  feedback = 0.0f;
-    float  lpState = 0.0f;
-    float  lpCoeff = 0.45f;
-
-    void init(int delaySamples, float fb) {
-        size = delaySamples;
-        if (size > 4096) size = 4096;
-        feedback = fb;
-        idx = 0;
-        lpState = 0.0f;
-        memset(buf, 0, sizeof(buf));
+// ─── Recorder: audio → sample ring → low-priority disk writer ──────────────
+// The audio thread copies each rendered float chunk (interleaved L/R, after
+// the soft clip and master gain, before PCM conversion) into a preallocated
+// single-producer/single-consumer ring while armed. A chunk that does not
+// fit is dropped and counted; the audio thread never waits. The writer
+// thread opens the file, drains the ring in REC_CHUNK_BYTES writes and
+// patches the WAV sizes on stop. /record 1 starts a take, /record 0 ends it;
+// a take that reaches REC_MAX_DATA_BYTES carries on, gap-free, in a new file.
+
+struct Recorder {
+    alignas(64) float ring[REC_RING_SAMPLES];
+    std::atomic<uint32_t> head{0};        // samples written (audio thread)
+    std::atomic<uint32_t> tail{0};        // samples consumed (writer)
+    std::atomic<bool>     armed{false};   // set by the writer once a file is open
+    std::atomic<bool>     request{false}; // control → writer
+    std::atomic<uint32_t> overflows{0};   // chunks dropped on a full ring
+    const char*           dir = "/usbdrive";
+
+    // Audio thread: all or nothing, never blocks
+    void push(const float* src, int n) {
+        if (!armed.load(std::memory_order_acquire)) return;
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if ((uint32_t)REC_RING_SAMPLES - (h - tail.load(std::memory_order_acquire)) < (uint32_t)n) {
+            overflows.store(overflows.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+            return;
+        }
+        uint32_t i = h & (REC_RING_SAMPLES - 1);
+        int first = REC_RING_SAMPLES - (int)i < n ? REC_RING_SAMPLES - (int)i : n;
+        memcpy(ring + i, src, first * sizeof(float));
+        memcpy(ring, src + first, (n - first) * sizeof(float));
+        head.store(h + n, std::memory_order_release);
     }
 
-    float process(float in) {
-        float out = buf[idx];
-        // One-pole LPF in feedback path (dark/warm character)
-        lpState = out + lpCoeff * (lpState - out);
-        buf[idx] = in + lpState * feedback;
-        idx++;
-        if (idx >= size) idx = 0;
-        return out;
+    // Writer: copy up to n samples out of the ring
+    int pop(float* dst, int n) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t avail = head.load(std::memory_order_acquire) - t;
+        if ((uint32_t)n > avail) n = (int)avail;
+        uint32_t i = t & (REC_RING_SAMPLES - 1);
+        int first = REC_RING_SAMPLES - (int)i < n ? REC_RING_SAMPLES - (int)i : n;
+        memcpy(dst, ring + i, first * sizeof(float));
+        memcpy(dst + first, ring, (n - first) * sizeof(float));
+        tail.store(t + n, std::memory_order_release);
+        return n;
     }
-};
 
-// ─── Allpass filter (diffusion) ─────────────────────────────────────────────
+    uint32_t pending() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+    }
+};
 
-struct Allpass {
-    float  buf[2048];
-    int    size = 0;
-    int    idx  = 0;
-    float  gain = 0.5f;
+// 32-bit float WAV header (format 3). Non-PCM data takes the 18-byte fmt
+// chunk (cbSize = 0) and a fact chunk with the frame count; both sizes are
+// patched in on stop
+static constexpr int WAV_HEADER_BYTES = 58;
+
+static void wav_float_header(uint8_t* h, uint32_t rate, uint32_t dataBytes) {
+    auto le = [&](int off, uint32_t v, int n) {
+        for (int i = 0; i < n; i++) h[off + i] = (uint8_t)(v >> (8 * i));
+    };
+    memcpy(h, "RIFF", 4);          le(4, WAV_HEADER_BYTES - 8 + dataBytes, 4);
+    memcpy(h + 8, "WAVEfmt ", 8);  le(16, 18, 4);
+    le(20, 3, 2);                  le(22, CHANNELS, 2);
+    le(24, rate, 4);               le(28, rate * CHANNELS * 4, 4);
+    le(32, CHANNELS * 4, 2);       le(34, 32, 2);
+    le(36, 0, 2);                  // cbSize
+    memcpy(h + 38, "fact", 4);     le(42, 4, 4);
+    le(46, dataBytes / (CHANNELS * 4), 4);
+    memcpy(h + 50, "data", 4);     le(54, dataBytes, 4);
+}
 
-    void init(int delaySamples, float g) {
-        size = delaySamples;
-        if (size > 2048) size = 2048;
-        gain = g;
-        idx = 0;
-        memset(buf, 0, sizeof(buf));
+// Next free <dir>/monosynth-NNN.wav, created exclusively
+static int rec_open(const char* dir, char* path, size_t len) {
+    for (int take = 1; take < 1000; take++) {
+        snprintf(path, len, "%s/monosynth-%03d.wav", dir, take);
+        int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+        if (fd >= 0 || errno != EEXIST) return fd;
     }
+    errno = EEXIST;
+    return -1;
+}
 
-    float process(float in) {
-        float delayed = buf[idx];
-        float out = -in + delayed;
-        buf[idx] = in + delayed * gain;
-        idx++;
-        if (idx >= size) idx = 0;
-        return out;
+static void* recorder_thread(void* arg) {
+    Recorder& rec = *(Recorder*)arg;
+    // Below the control thread: on Linux this renices only the calling thread
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), REC_NICE);
+    alignas(4096) static float chunk[REC_CHUNK_BYTES / sizeof(float)];
+    const int chunkSamples = REC_CHUNK_BYTES / sizeof(float);
+    char     path[256];
+    int      fd = -1;
+    uint64_t dataBytes = 0;
+    uint32_t overflowsAtStart = 0;
+
+    // Next file of the take, with a placeholder header
+    auto openFile = [&]() {
+        fd = rec_open(rec.dir, path, sizeof(path));
+        if (fd < 0) {
+            fprintf(stderr, "record: %s: %s\n", rec.dir, strerror(errno));
+            return false;
+        }
+        uint8_t hdr[WAV_HEADER_BYTES];
+        wav_float_header(hdr, (uint32_t)g_sampleRate, 0);
+        if (write(fd, hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr))
+            fprintf(stderr, "record: header %s: %s\n", path, strerror(errno));
+        dataBytes = 0;
+        overflowsAtStart = rec.overflows.load(std::memory_order_relaxed);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        fprintf(stderr, "record: %s\n", path);
+        return true;
+    };
+    auto closeFile = [&]() {
+        uint8_t hdr[WAV_HEADER_BYTES];
+        wav_float_header(hdr, (uint32_t)g_sampleRate, (uint32_t)dataBytes);
+        if (pwrite(fd, hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr))
+            fprintf(stderr, "record: header %s: %s\n", path, strerror(errno));
+        fsync(fd);
+        close(fd);
+        fd = -1;
+        fprintf(stderr, "record: %s closed, %.1f s, %u chunks dropped\n", path,
+                dataBytes / (4.0 * CHANNELS * g_sampleRate),
+                rec.overflows.load(std::memory_order_relaxed) - overflowsAtStart);
+    };
+
+    while (g_running || fd >= 0) {
+        bool want = g_running && rec.request.load(std::memory_order_acquire);
+        if (want && fd < 0) {
+            if (!openFile()) {
+                rec.request.store(false);
+            } else {
+                rec.tail.store(rec.head.load(std::memory_order_acquire),
+                               std::memory_order_release);   // drop the last take's leftovers
+                rec.armed.store(true, std::memory_order_release);
+            }
+        }
+
+        // Full chunks while recording; everything left once stopping
+        if (fd >= 0) {
+            if (!want) rec.armed.store(false, std::memory_order_release);
+            while (rec.pending() >= (uint32_t)chunkSamples || (!want && rec.pending() > 0)) {
+                int n = rec.pop(chunk, chunkSamples);
+                ssize_t bytes = (ssize_t)(n * sizeof(float));
+                if (dataBytes + bytes > REC_MAX_DATA_BYTES) {
+                    // 32-bit sizes full: close this file, the chunk opens the next
+                    closeFile();
+                    if (!openFile()) {
+                        rec.request.store(false);
+                        rec.armed.store(false, std::memory_order_release);
+                        want = false;
+                        break;
+                    }
+                }
+                if (write(fd, chunk, bytes) != bytes) {
+                    fprintf(stderr, "record: write %s: %s\n", path, strerror(errno));
+                    rec.request.store(false);
+                    want = false;
+                    break;
+                }
+                // Start writeback now rather than letting the page cache
+                // flush seconds of audio in one burst
+                posix_fadvise(fd, WAV_HEADER_BYTES + dataBytes, bytes, POSIX_FADV_DONTNEED);
+                dataBytes += bytes;
+            }
+            if (!want && fd >= 0) {
+                rec.armed.store(false, std::memory_order_release);
+                closeFile();
+            }
+        }
+        usleep(REC_POLL_MS * 1000);
     }
-};
+    return nullptr;
+}
 
-// ─── Stereo Reverb (Schroeder, SP404-inspired) ─────────────────────────────
+struct AudioContext {
+    AudioOut*                   audio;
+    Synth*                      synth;
+    ParamQueue*                 params;   // control → audio
+    SpscRing<MeterFrame, 64>*   meters;   // audio → control
+    LoadHistogram*              hist;
+    Recorder*                   rec;      // audio → disk writer
+};
 
-struct Reverb {
-    // 4 LP-comb filters per channel (L/R have different prime delays for stereo)
-    LPComb combL[4];
-    LPComb combR[4];
-    // 2 allpass filters per channel
-    Allpass apL[2];
-    Allpass apR[2];
+struct TimedEvent {
+    int        offset;   // frame within the period
+    ParamEvent ev;
+};
 
-    float wet = 0.0f;
-    float amount = 0.0f;
+static void* audio_thread(void* arg) {
+    AudioContext& ctx = *(AudioContext*)arg;
+    Synth& synth = *ctx.synth;
+    static TimedEvent pending[256];
+    enable_flush_to_zero();   // FPU mode is per thread
+    uint64_t prevStartNs = now_ns();
+    const uint64_t rate = ctx.audio->rate;   // reconfigure() never changes it
+    static float mix[MAX_PERIOD_FRAMES * CHANNELS];   // float render, converted per chunk
+
+    // Auto-tune: any xrun inside the window (after a short start-up grace)
+    // doubles the period; a clean AUTOTUNE_STABLE_MS ends tuning
+    bool     tuning      = ctx.audio->tuning.load();
+    uint64_t tuneStartNs = prevStartNs;
+    uint32_t tuneXruns   = ctx.audio->xruns.load();
 
-    void init() {
-        // Comb delay times (near-prime sample counts, ~40-50ms for larger room)
-        // L channel
-        combL[0].init(1764, 0.88f);  // ~40.0ms
-        combL[1].init(1887, 0.86f);  // ~42.8ms
-        combL[2].init(2023, 0.90f);  // ~45.9ms
-        combL[3].init(2197, 0.92f);  // ~49.8ms
-        // R channel (slightly offset for stereo width)
-        combR[0].init(1789, 0.88f);
-        combR[1].init(1913, 0.86f);
-        combR[2].init(2053, 0.90f);
-        combR[3].init(2232, 0.92f);
-
-        // Allpass diffusers (~7ms and ~2.5ms for more diffusion)
-        apL[0].init(307, 0.5f);   // ~7.0ms
-        apL[1].init(113, 0.5f);   // ~2.6ms
-        apR[0].init(331, 0.5f);   // ~7.5ms (offset)
-        apR[1].init(127, 0.5f);   // ~2.9ms (offset)
-    }
-
-    void updateFromDynamics(float length, float releaseNorm) {
-        amount = length * (0.5f + 0.5f * releaseNorm);
-        wet = amount * 0.85f;
-    }
-
-    void process(float in, float& outL, float& outR) {
-        // Sum of 4 parallel combs per channel
-        float sumL = 0.0f, sumR = 0.0f;
-        for (int i = 0; i < 4; i++) {
-            sumL += combL[i].process(in);
-            sumR += combR[i].process(in);
+    while (g_running) {
+        const int      periodFrames = (int)ctx.audio->period;
+        const uint32_t deadlineNs   = (uint32_t)(1000000000ull * periodFrames / rate);
+
+        // Events that arrived during the previous period play back at the
+        // same offset within this one: one period of fixed latency, no jitter
+        uint64_t startNs = now_ns();
+        int nev = 0, lastOff = 0;
+        ParamEvent ev;
+        while (nev < 256 && ctx.params->peek(ev) && ev.timeNs <= startNs) {
+            ctx.params->pop(ev);
+            int64_t dt = (int64_t)(ev.timeNs - prevStartNs);
+            int off = (dt <= 0) ? 0 : (int)((uint64_t)dt * rate / 1000000000ull);
+            if (off > periodFrames - 1) off = periodFrames - 1;
+            if (off < lastOff) off = lastOff;
+            lastOff = off;
+            pending[nev++] = {off, ev};
+        }
+        uint32_t wallNs = (uint32_t)(startNs - prevStartNs);
+        prevStartNs = startNs;
+        uint64_t renderNs = 0;
+
+        // Render one period into the DMA ring (mmap) or the staging buffer;
+        // mmap may hand out the period in two pieces at the ring wrap. The
+        // render is split at each event offset so notes start on their sample.
+        int remaining = periodFrames;
+        int periodPos = 0, evIdx = 0;
+        while (remaining > 0 && g_running) {
+            uint8_t* dst;
+            snd_pcm_sframes_t frames = ctx.audio->begin(&dst, remaining);
+            if (frames == 0) continue;
+            if (frames > 0) {
+                uint64_t r0 = now_ns();
+                int done = 0;
+                while (evIdx < nev && pending[evIdx].offset < periodPos + (int)frames) {
+                    int at = pending[evIdx].offset - periodPos;
+                    if (at > done) {
+                        synth.render(mix + done * CHANNELS, at - done);
+                        done = at;
+                    }
+                    synth.apply(pending[evIdx++].ev);
+                }
+                synth.render(mix + done * CHANNELS, (int)frames - done);
+                ctx.rec->push(mix, (int)frames * CHANNELS);
+                convert_samples(mix, dst, (int)frames * CHANNELS, ctx.audio->format);
+                renderNs += now_ns() - r0;
+                periodPos += (int)frames;
+                remaining -= (int)frames;
+                frames = ctx.audio->commit(frames);
+            }
+            if (frames < 0) {
+                g_audioError.store((int)frames);
+                return nullptr;
+            }
         }
-        sumL *= 0.25f;
-        sumR *= 0.25f;
 
-        // Series allpass diffusion
-        for (int i = 0; i < 2; i++) {
-            sumL = apL[i].process(sumL);
-            sumR = apR[i].process(sumR);
+        ctx.hist->add((uint32_t)renderNs, deadlineNs);
+        MeterFrame mf = synth.takeMeter();
+        mf.renderNs = (uint32_t)renderNs;
+        mf.wallNs   = wallNs;
+        mf.frames   = (uint32_t)periodFrames;
+        ctx.meters->push(mf);   // dropped if control lags
+
+        if (tuning) {
+            uint64_t t = now_ns();
+            uint32_t x = ctx.audio->xruns.load(std::memory_order_relaxed);
+            bool done = false;
+            if (t - tuneStartNs < AUTOTUNE_GRACE_MS * 1000000ull) {
+                tuneXruns = x;
+            } else if (x != tuneXruns) {
+                if (periodFrames * 2 > MAX_PERIOD_FRAMES) {
+                    done = true;   // nothing larger to try; keep this one
+                } else {
+                    int err = ctx.audio->reconfigure((snd_pcm_uframes_t)periodFrames * 2);
+                    if (err < 0) {
+                        g_audioError.store(err);
+                        return nullptr;
+                    }
+                    if (err > 0) done = true;   // refused; back on this period
+                    tuneStartNs = prevStartNs = now_ns();
+                    tuneXruns   = ctx.audio->xruns.load(std::memory_order_relaxed);
+                }
+            } else if (t - tuneStartNs >= AUTOTUNE_STABLE_MS * 1000000ull) {
+                done = true;
+            }
+            if (done) {
+                tuning = false;
+                ctx.audio->tuning.store(false, std::memory_order_release);
+            }
         }
+    }
+    return nullptr;
+}
 
-        // Dry/wet mix
-        outL = in + wet * (sumL - in);
-        outR = in + wet * (sumR - in);
+// ─── OSC ingest: batched receive + address dispatch ────────────────────────
+
+static constexpr int OSC_RX_BATCH = 32;    // datagrams per recvmmsg
+static constexpr int OSC_RX_MAX   = 512;   // largest datagram we parse
+
+// recvmmsg() plus each datagram's kernel arrival stamp (SO_TIMESTAMPNS,
+// CLOCK_REALTIME) mapped onto CLOCK_MONOTONIC via realToMonoNs; falls back
+// to "now"
+struct OscRx {
+    uint8_t        buf[OSC_RX_BATCH][OSC_RX_MAX];
+    int            len[OSC_RX_BATCH];
+    uint64_t       timeNs[OSC_RX_BATCH];
+    struct mmsghdr hdr[OSC_RX_BATCH];
+    struct iovec   iov[OSC_RX_BATCH];
+    union {
+        char           space[CMSG_SPACE(sizeof(struct timespec))];
+        struct cmsghdr align;
+    } ctrl[OSC_RX_BATCH];
+
+    // Returns the number of datagrams received (0 = socket drained)
+    int receive(int sock, int64_t realToMonoNs) {
+        memset(hdr, 0, sizeof(hdr));
+        for (int i = 0; i < OSC_RX_BATCH; i++) {
+            iov[i] = {buf[i], OSC_RX_MAX};
+            hdr[i].msg_hdr.msg_iov        = &iov[i];
+            hdr[i].msg_hdr.msg_iovlen     = 1;
+            hdr[i].msg_hdr.msg_control    = ctrl[i].space;
+            hdr[i].msg_hdr.msg_controllen = sizeof(ctrl[i].space);
+        }
+        int n = recvmmsg(sock, hdr, OSC_RX_BATCH, MSG_DONTWAIT, nullptr);
+        if (n <= 0) return 0;
+
+        uint64_t now = now_ns();
+        for (int i = 0; i < n; i++) {
+            len[i]    = (int)hdr[i].msg_len;
+            timeNs[i] = now;
+            struct msghdr* msg = &hdr[i].msg_hdr;
+            for (struct cmsghdr* c = CMSG_FIRSTHDR(msg); c; c = CMSG_NXTHDR(msg, c)) {
+                if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+                    struct timespec ts;
+                    memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                    int64_t real = (int64_t)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+                    uint64_t mono = (uint64_t)(real - realToMonoNs);
+                    if (mono < timeNs[i]) timeNs[i] = mono;
+                }
+            }
+        }
+        return n;
     }
 };
 
-// ─── MIDI note → frequency ──────────────────────────────────────────────────
+enum OscAddr { OSC_KEY, OSC_KNOBS, OSC_AUX, OSC_STATS, OSC_RECORD, OSC_MOD,
+               OSC_PRESET_RECALL, OSC_PRESET_STORE, OSC_QUIT, OSC_UNKNOWN };
 
-static inline float mtof(int note) {
-    return 440.0f * exp2f((note - 69) / 12.0f);
-}
+// Address → handler id: FNV-1a into a small open-addressed table filled at
+// startup; a hit costs one hash and one strcmp to confirm
+struct OscDispatch {
+    static constexpr uint32_t SIZE = 32;   // power of two, ≥ 2× the entries
+    const char* path[SIZE] = {};
+    OscAddr     id[SIZE];
 
-// ─── Voice ───────────────────────────────────────────────────────────────────
-
-struct Voice {
-    NoteStack  stack;
-    Oscillator osc;
-    Portamento porta;
-    SVFilter   filt;
-    Envelope   env;
-    bool       gateOn = false;
-    int        targetWaveform = 0;
-    float      morphPos = 0.0f;
-
-    void noteOn(int note) {
-        bool legato = gateOn;
-        stack.push(note);
-        float freq = mtof(note);
-        if (legato) {
-            porta.setTarget(freq);
-        } else {
-            porta.snap(freq);
-            env.gate(true);
-        }
-        gateOn = true;
+    static uint32_t hash(const char* s) {
+        uint32_t h = 2166136261u;
+        while (*s) { h ^= (uint8_t)*s++; h *= 16777619u; }
+        return h;
     }
 
-    void noteOff(int note) {
-        stack.remove(note);
-        if (stack.empty()) {
-            env.gate(false);
-            gateOn = false;
-        } else {
-            // Glide to the new top note (legato)
-            porta.setTarget(mtof(stack.top()));
-        }
+    void add(const char* p, OscAddr a) {
+        uint32_t i = hash(p) & (SIZE - 1);
+        while (path[i]) i = (i + 1) & (SIZE - 1);
+        path[i] = p;
+        id[i]   = a;
     }
 
-    float tick() {
-        osc.freq = porta.tick();
-        osc.advance();
+    OscAddr find(const char* p) const {
+        for (uint32_t i = hash(p) & (SIZE - 1); path[i]; i = (i + 1) & (SIZE - 1))
+            if (strcmp(path[i], p) == 0) return id[i];
+        return OSC_UNKNOWN;
+    }
+};
 
-        // Smooth morphPos toward targetWaveform (reuses portamento speed)
-        float target = (float)targetWaveform;
-        morphPos += porta.coeff * (target - morphPos);
-        if (fabsf(morphPos - target) < 0.001f) morphPos = target;
+// Producer side of the param ring for ordered events (notes, waveform, mod
+// routes, patches). /knobs only goes in while PARAM_NOTE_RESERVE slots stay
+// free (knob_room), so a note normally finds room even behind a burst; one
+// that still doesn't fit waits here, in order, and goes out before anything
+// newer, so a NOTE_OFF is never silently lost and no key sticks.
+struct ParamSender {
+    static constexpr int BACKLOG = 256;
+    ParamQueue* q = nullptr;
+    ParamEvent  backlog[BACKLOG];
+    int         first = 0, count = 0;
+    uint32_t    deferred = 0;   // events that met a full ring (knob decodes included)
+    uint32_t    dropped  = 0;   // ordered events lost with the backlog full as well
+
+    bool idle() const { return count == 0; }
+
+    // Push what fits of the backlog, oldest first
+    void retry() {
+        while (count > 0 && q->push(backlog[first])) {
+            first = (first + 1) % BACKLOG;
+            count--;
+        }
+    }
 
-        // Crossfade between adjacent waveforms during morph
-        float s;
-        int lo = (int)floorf(morphPos);
-        float frac = morphPos - (float)lo;
-        int loIdx = ((lo % NUM_WAVEFORMS) + NUM_WAVEFORMS) % NUM_WAVEFORMS;
+    void send(const ParamEvent& e) {
+        retry();
+        if (count == 0 && q->push(e)) return;
+        deferred++;
+        if (count == BACKLOG) { dropped++; return; }
+        backlog[(first + count++) % BACKLOG] = e;
+    }
 
-        if (frac < 0.001f) {
-            s = osc.waveform(loIdx);
-        } else {
-            int hiIdx = (loIdx + 1) % NUM_WAVEFORMS;
-            s = osc.waveform(loIdx) * (1.0f - frac) + osc.waveform(hiIdx) * frac;
-        }
+    // Immediate or not at all, behind any backlog (the caller handles failure)
+    bool trySend(const ParamEvent& e) {
+        retry();
+        if (count == 0 && q->push(e)) return true;
+        deferred++;
+        return false;
+    }
 
-        s = filt.tick(s);
-        s *= env.tick();
-        return s;
+    // /knobs decode: only with nothing queued ahead and the note reserve free
+    bool knobRoom() {
+        retry();
+        if (count == 0 && knob_room(*q)) return true;
+        deferred++;
+        return false;
     }
 };
 
-// ─── OSC helpers ─────────────────────────────────────────────────────────────
+// ─── Preset bank (mmap-ed file on the USB drive) ───────────────────────────
+// Header + PRESET_SLOTS fixed-layout presets, mapped shared at startup
+// (mlockall then keeps the pages resident): recall reads memory, store
+// writes it and schedules the flush. Control thread only.
 
-// Round up to next multiple of 4
-static inline int osc_pad(int n) { return (n + 3) & ~3; }
+struct PresetBank {
+    uint32_t magic;
+    uint8_t  last;           // recalled at startup
+    uint8_t  reserved[59];
+    Preset   slot[PRESET_SLOTS];
+};
+static_assert(sizeof(PresetBank) == 64 + PRESET_SLOTS * sizeof(Preset), "on-disk layout");
 
-// Parse an int32 from OSC data (big-endian)
-static inline int32_t osc_int(const uint8_t* p) {
-    return (int32_t)ntohl(*(const uint32_t*)p);
+static PresetBank* preset_bank_open(const char* path) {
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "presets %s: %s\n", path, strerror(errno));
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || ((size_t)st.st_size < sizeof(PresetBank)
+                               && ftruncate(fd, sizeof(PresetBank)) < 0)) {
+        fprintf(stderr, "presets %s: %s\n", path, strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    void* m = mmap(nullptr, sizeof(PresetBank), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) {
+        fprintf(stderr, "presets %s: mmap: %s\n", path, strerror(errno));
+        return nullptr;
+    }
+    PresetBank* bank = (PresetBank*)m;
+    if (bank->magic == 0) {
+        bank->magic = PRESET_MAGIC;   // new (zero-filled) bank
+    } else if (bank->magic != PRESET_MAGIC) {
+        fprintf(stderr, "presets %s: not a preset bank\n", path);
+        munmap(m, sizeof(PresetBank));
+        return nullptr;
+    }
+    return bank;
 }
 
-// ─── OSC display helper (send string to mother on port 4001) ─────────────────
+// ─── Start-up: PCM open + hw_params, concurrent with the socket setup ──────
+// The device is polled every INIT_RETRY_MS while JACK (or the previous
+// patch) lets go of it, instead of sleeping in large fixed steps.
+
+struct AlsaInit {
+    AudioOut*           audio;
+    snd_pcm_uframes_t   periodReq;
+    snd_pcm_uframes_t   bufPeriods;
+    int                 motherSock;
+    struct sockaddr_in* motherAddr;
+    int                 err      = 0;
+    int                 exitCode = 0;   // 4 = open failed, 5 = hw_params failed
+    int                 attempts = 0;
+    uint64_t            openNs   = 0;   // time spent waiting for the device
+    uint64_t            configNs = 0;
+};
 
-static void osc_send_str(int sock, struct sockaddr_in* addr,
-                          const char* path, const char* text) {
-    uint8_t buf[256];
-    int plen = osc_pad((int)strlen(path) + 1);
-    int tlen = osc_pad((int)strlen(text) + 1);
-    int total = plen + 4 + tlen;  // path + ",s\0\0" + text
-    if (total > (int)sizeof(buf)) return;
-    memset(buf, 0, total);
-    memcpy(buf, path, strlen(path));
-    int off = plen;
-    buf[off++] = ','; buf[off++] = 's'; buf[off++] = 0; buf[off++] = 0;
-    memcpy(buf + plen + 4, text, strlen(text));
-    sendto(sock, buf, total, 0,
-           (struct sockaddr*)addr, sizeof(*addr));
-}
+static void* alsa_init_thread(void* arg) {
+    AlsaInit& ai = *(AlsaInit*)arg;
+    uint64_t t0 = now_ns(), nextReport = t0 + INIT_REPORT_MS * 1000000ull;
+    snd_pcm_t* pcm = nullptr;
+    int err = -1;
+    for (;;) {
+        ai.attempts++;
+        err = snd_pcm_open(&pcm, "hw:0", SND_PCM_STREAM_PLAYBACK, 0);
+        if (err == 0) break;
+        err = snd_pcm_open(&pcm, "plughw:0,0", SND_PCM_STREAM_PLAYBACK, 0);
+        if (err == 0) break;
+        uint64_t now = now_ns();
+        if (now - t0 >= INIT_TIMEOUT_MS * 1000000ull) break;
+        if (now >= nextReport) {
+            fprintf(stderr, "ALSA open: %s, retrying\n", snd_strerror(err));
+            char msg[32];
+            snprintf(msg, sizeof(msg), "ALSA wait %.1fs", (now - t0) * 1e-9);
+            osc_send_str(ai.motherSock, ai.motherAddr, "/oled/line/2", msg);
+            nextReport = now + INIT_REPORT_MS * 1000000ull;
+        }
+        usleep(INIT_RETRY_MS * 1000);
+    }
+    ai.openNs = now_ns() - t0;
+    if (err < 0) {
+        ai.err = err;
+        ai.exitCode = 4;
+        return nullptr;
+    }
 
-// ─── OSC helper: send 5 ints (for /oled/gBox x1 y1 x2 y2 fill) ─────────────
-
-static void osc_send_5i(int sock, struct sockaddr_in* addr,
-                         const char* path, int v0, int v1, int v2, int v3, int v4) {
-    uint8_t buf[256];
-    int plen = osc_pad((int)strlen(path) + 1);
-    // Type tag: ,iiiii + pad to 4-byte boundary = 8 bytes
-    int total = plen + 8 + 5 * 4;
-    if (total > (int)sizeof(buf)) return;
-    memset(buf, 0, total);
-    memcpy(buf, path, strlen(path));
-    int off = plen;
-    buf[off++] = ','; buf[off++] = 'i'; buf[off++] = 'i'; buf[off++] = 'i';
-    buf[off++] = 'i'; buf[off++] = 'i'; off += 2;  // null + pad
-    int32_t vals[] = {v0, v1, v2, v3, v4};
-    for (int j = 0; j < 5; j++) {
-        uint32_t nv = htonl((uint32_t)vals[j]);
-        memcpy(buf + off, &nv, 4);
-        off += 4;
-    }
-    sendto(sock, buf, total, 0,
-           (struct sockaddr*)addr, sizeof(*addr));
+    // Prefer mmap (render straight into the DMA ring, 2 periods of buffer);
+    // fall back to writei from a staging buffer with 4 periods
+    uint64_t t1 = now_ns();
+    AudioOut& audio = *ai.audio;
+    audio.pcm = pcm;
+    err = audio.configure(SND_PCM_ACCESS_MMAP_INTERLEAVED, ai.periodReq,
+                          ai.bufPeriods ? ai.bufPeriods : 2);
+    if (err < 0) {
+        fprintf(stderr, "ALSA mmap unavailable (%s), using writei\n", snd_strerror(err));
+        err = audio.configure(SND_PCM_ACCESS_RW_INTERLEAVED, ai.periodReq,
+                              ai.bufPeriods ? ai.bufPeriods : 4);
+    }
+    ai.configNs = now_ns() - t1;
+    if (err < 0) {
+        ai.err = err;
+        ai.exitCode = 5;
+    }
+    return nullptr;
 }
 
-// ─── OSC helper: send 1 int (for /led) ──────────────────────────────────────
+// ─── Main ────────────────────────────────────────────────────────────────────
 
-static void osc_send_1i(int sock, struct sockaddr_in* addr,
-                         const char* path, int v0) {
-    uint8_t buf[64];
-    int plen = osc_pad((int)strlen(path) + 1);
-    int total = plen + 4 + 4;  // path + ",i\0\0" + int
-    if (total > (int)sizeof(buf)) return;
-    memset(buf, 0, total);
-    memcpy(buf, path, strlen(path));
-    int off = plen;
-    buf[off++] = ','; buf[off++] = 'i'; buf[off++] = 0; buf[off++] = 0;
-    uint32_t nv = htonl((uint32_t)v0);
-    memcpy(buf + off, &nv, 4);
-    sendto(sock, buf, total, 0,
-           (struct sockaddr*)addr, sizeof(*addr));
+static Wavetables g_wavetables;
+
+// Config file: one option per line, the flag name without "--" and an
+// optional value ("period 64", "buffer = 256", "poly"); '#' comments.
+// Expanded in place, so options after --config on the command line win.
+static bool load_config(const char* path, std::vector<std::string>& args) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "config %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char* hash = strchr(line, '#');
+        if (hash) *hash = 0;
+        for (char* c = line; *c; c++) if (*c == '=') *c = ' ';
+        char key[64], val[128];
+        int n = sscanf(line, "%63s %127s", key, val);
+        if (n >= 1) args.push_back(std::string("--") + key);
+        if (n == 2) args.push_back(val);
+    }
+    fclose(f);
+    return true;
 }
 
-// ─── Main ────────────────────────────────────────────────────────────────────
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--config FILE] [--period N] [--buffer N] [--autotune]\n"
+                    "          [--poly] [--wavetable] [--oversample N] [--control-interval N]\n"
+                    "          [--fdn-reverb] [--stats-oled] [--osc-bundle] [--record-dir DIR]\n"
+                    "          [--presets FILE] [--unison N] [--detune CENTS] [--spread S]\n"
+                    "  --config FILE         read options from FILE (one per line, no \"--\")\n"
+                    "  --period N            ALSA period in frames (%d-%d, default %d)\n"
+                    "  --buffer N            ALSA buffer in frames (default 2 periods mmap, 4 writei)\n"
+                    "  --autotune            start at %d frames (or --period), double on xruns\n"
+                    "                        until %d s run clean, show the latency on the OLED\n"
+                    "  --poly                %d-voice polyphonic mode (default: mono, legato)\n"
+                    "  --wavetable           band-limited wavetable oscillators instead of PolyBLEP\n"
+                    "  --unison N            mono mode: stack of N (2-%d) detuned PolyBLEP copies,\n"
+                    "                        spread across the stereo reverb\n"
+                    "  --detune CENTS        unison stack width, +/- cents (default %.0f)\n"
+                    "  --spread S            unison stereo spread 0-1 (default %.1f)\n"
+                    "  --oversample N        run heavy distortion at 2x or 4x (default 1 = off)\n"
+                    "  --fdn-reverb          8-line FDN reverb instead of the Schroeder bank\n"
+                    "  --control-interval N  k-rate parameter period in samples (1-%d, default %d)\n"
+                    "  --stats-oled          show DSP load / xruns on OLED line 5 instead of Dst/Rvb\n"
+                    "  --osc-bundle          send each display frame as one OSC #bundle\n"
+                    "                        (default: one sendmmsg of plain messages)\n"
+                    "  --record-dir DIR      where /record 1 writes monosynth-NNN.wav (default /usbdrive)\n"
+                    "  --presets FILE        preset bank (default /usbdrive/monosynth-presets.bin)\n",
+            argv0, MIN_PERIOD_FRAMES, MAX_PERIOD_FRAMES, PERIOD_FRAMES,
+            AUTOTUNE_START_FRAMES, AUTOTUNE_STABLE_MS / 1000,
+            POLY_VOICES, UNISON_MAX, UNISON_DETUNE, UNISON_SPREAD,
+            BLOCK_FRAMES, CONTROL_INTERVAL);
+}
+
+int main(int argc, char** argv) {
+    const uint64_t startNs = now_ns();   // init-phase timings are relative to this
+    std::vector<std::string> args;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--config") == 0 && a + 1 < argc) {
+            if (!load_config(argv[++a], args)) return 7;
+        } else {
+            args.push_back(argv[a]);
+        }
+    }
+
+    bool useWavetable = false;
+    bool polyMode = false;
+    bool statsOled = false;
+    bool autotune = false;
+    bool oscBundle = false;
+    bool fdnReverb = false;
+    int  unison = 0;
+    float detune = UNISON_DETUNE, spread = UNISON_SPREAD;
+    int  oversample = 1;
+    int  controlInterval = CONTROL_INTERVAL;
+    int  periodReq = 0;     // 0 = default for the mode
+    int  bufferReq = 0;     // 0 = default periods per buffer
+    const char* recordDir = "/usbdrive";
+    const char* presetPath = "/usbdrive/monosynth-presets.bin";
+    for (size_t a = 0; a < args.size(); a++) {
+        const char* opt = args[a].c_str();
+        bool hasVal = a + 1 < args.size();
+        if (strcmp(opt, "--wavetable") == 0) useWavetable = true;
+        else if (strcmp(opt, "--poly") == 0) polyMode = true;
+        else if (strcmp(opt, "--stats-oled") == 0) statsOled = true;
+        else if (strcmp(opt, "--autotune") == 0) autotune = true;
+        else if (strcmp(opt, "--osc-bundle") == 0) oscBundle = true;
+        else if (strcmp(opt, "--fdn-reverb") == 0) fdnReverb = true;
+        else if (strcmp(opt, "--unison") == 0 && hasVal)
+            unison = atoi(args[++a].c_str());
+        else if (strcmp(opt, "--detune") == 0 && hasVal)
+            detune = atof(args[++a].c_str());
+        else if (strcmp(opt, "--spread") == 0 && hasVal)
+            spread = atof(args[++a].c_str());
+        else if (strcmp(opt, "--oversample") == 0 && hasVal)
+            oversample = atoi(args[++a].c_str());
+        else if (strcmp(opt, "--control-interval") == 0 && hasVal)
+            controlInterval = atoi(args[++a].c_str());
+        else if (strcmp(opt, "--period") == 0 && hasVal)
+            periodReq = atoi(args[++a].c_str());
+        else if (strcmp(opt, "--buffer") == 0 && hasVal)
+            bufferReq = atoi(args[++a].c_str());
+        else if (strcmp(opt, "--record-dir") == 0 && hasVal)
+            recordDir = args[++a].c_str();
+        else if (strcmp(opt, "--presets") == 0 && hasVal)
+            presetPath = args[++a].c_str();
+        else { usage(argv[0]); return 7; }
+    }
+    if (periodReq == 0) periodReq = autotune ? AUTOTUNE_START_FRAMES : PERIOD_FRAMES;
+    if (periodReq < MIN_PERIOD_FRAMES || periodReq > MAX_PERIOD_FRAMES
+        || (bufferReq != 0 && bufferReq < 2 * periodReq)
+        || (unison != 0 && (unison < 2 || unison > UNISON_MAX || polyMode))
+        || detune < 0.0f || detune > 100.0f || spread < 0.0f || spread > 1.0f) {
+        usage(argv[0]);
+        return 7;
+    }
+    // The buffer is kept as a period count, so auto-tune scales it along
+    const snd_pcm_uframes_t bufPeriods = (snd_pcm_uframes_t)(bufferReq / periodReq);
 
-int main() {
     // Signal handling
     signal(SIGTERM, sig_handler);
     signal(SIGINT,  sig_handler);
+#if MONOSYNTH_PROBES
+    probe_init();
+    signal(SIGUSR1, probe_sig_handler);
+    fprintf(stderr, "Probes: on (%s), kill -USR1 for the table\n",
+            g_probeCycles ? "PMCCNTR" : "clock_gettime");
+#endif
 
     // ── UDP socket for sending to mother (port 4001) — create FIRST for OLED diag ──
     int mother_sock = socket(AF_INET, SOCK_DGRAM, 0);
@@ -614,15 +1134,30 @@ int main() {
 
     osc_send_str(mother_sock, &mother_addr, "/oled/line/2", "Init sockets...");
 
+    // ── ALSA comes up on its own thread while the OSC socket binds ──
+    AudioOut audio;
+    AlsaInit alsaInit{&audio, (snd_pcm_uframes_t)periodReq, bufPeriods,
+                      mother_sock, &mother_addr};
+    pthread_t alsa_tid;
+    bool alsaThread = pthread_create(&alsa_tid, nullptr, alsa_init_thread, &alsaInit) == 0;
+    if (!alsaThread) alsa_init_thread(&alsaInit);   // same work, in sequence
+    auto abortInit = [&]() {   // sockets failed: wait for ALSA, then release it
+        if (alsaThread) pthread_join(alsa_tid, nullptr);
+        if (audio.pcm) snd_pcm_close(audio.pcm);
+    };
+
     // ── UDP socket for OSC receive (port 4000) ──
     int osc_sock = socket(AF_INET, SOCK_DGRAM, 0);
     if (osc_sock < 0) {
         perror("socket");
         osc_send_str(mother_sock, &mother_addr, "/oled/line/2", "socket() FAIL");
+        abortInit();
         sleep(5); close(mother_sock); return 2;
     }
     int reuse = 1;
     setsockopt(osc_sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    // Kernel arrival timestamps for sample-accurate event placement
+    setsockopt(osc_sock, SOL_SOCKET, SO_TIMESTAMPNS, &reuse, sizeof(reuse));
     // Non-blocking
     fcntl(osc_sock, F_SETFL, O_NONBLOCK);
 
@@ -631,89 +1166,175 @@ int main() {
     bind_addr.sin_port        = htons(OSC_PORT);
     bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
 
-    // Retry bind in case port 4000 is still in TIME_WAIT
-    int bind_err = -1;
-    for (int attempt = 0; attempt < 10; attempt++) {
+    // Poll bind while the previous patch still holds port 4000
+    int bind_err = -1, bindAttempts = 0;
+    uint64_t bindStartNs = now_ns(), nextReportNs = bindStartNs + INIT_REPORT_MS * 1000000ull;
+    for (;;) {
+        bindAttempts++;
         bind_err = bind(osc_sock, (struct sockaddr*)&bind_addr, sizeof(bind_addr));
         if (bind_err == 0) break;
-        fprintf(stderr, "bind attempt %d failed: %s\n", attempt + 1, strerror(errno));
-        char msg[32];
-        snprintf(msg, sizeof(msg), "bind retry %d/10", attempt + 1);
-        osc_send_str(mother_sock, &mother_addr, "/oled/line/2", msg);
-        usleep(500000);
+        uint64_t now = now_ns();
+        if (now - bindStartNs >= INIT_TIMEOUT_MS * 1000000ull) break;
+        if (now >= nextReportNs) {
+            fprintf(stderr, "bind: %s, retrying\n", strerror(errno));
+            char msg[32];
+            snprintf(msg, sizeof(msg), "bind wait %.1fs", (now - bindStartNs) * 1e-9);
+            osc_send_str(mother_sock, &mother_addr, "/oled/line/2", msg);
+            nextReportNs = now + INIT_REPORT_MS * 1000000ull;
+        }
+        usleep(INIT_RETRY_MS * 1000);
     }
+    uint64_t socketsNs = now_ns() - startNs;
     if (bind_err < 0) {
         perror("bind");
         osc_send_str(mother_sock, &mother_addr, "/oled/line/2", "bind:4000 FAIL");
+        abortInit();
         sleep(5); close(osc_sock); close(mother_sock); return 3;
     }
 
     osc_send_str(mother_sock, &mother_addr, "/oled/line/2", "Sockets OK");
 
-    // ── ALSA setup (retry in case JACK hasn't released the device yet) ──
-    snd_pcm_t* pcm = nullptr;
-    int err = -1;
-    for (int attempt = 0; attempt < 10; attempt++) {
-        err = snd_pcm_open(&pcm, "hw:0", SND_PCM_STREAM_PLAYBACK, 0);
-        if (err == 0) break;
-        err = snd_pcm_open(&pcm, "plughw:0,0", SND_PCM_STREAM_PLAYBACK, 0);
-        if (err == 0) break;
-        fprintf(stderr, "ALSA open attempt %d failed: %s\n", attempt + 1, snd_strerror(err));
-        char msg[32];
-        snprintf(msg, sizeof(msg), "ALSA retry %d/10", attempt + 1);
-        osc_send_str(mother_sock, &mother_addr, "/oled/line/2", msg);
-        usleep(500000);
-    }
-    if (err < 0) {
-        fprintf(stderr, "ALSA open: all attempts failed: %s\n", snd_strerror(err));
+    if (alsaThread) pthread_join(alsa_tid, nullptr);
+    if (alsaInit.exitCode == 4) {
+        fprintf(stderr, "ALSA open: all attempts failed: %s\n", snd_strerror(alsaInit.err));
         osc_send_str(mother_sock, &mother_addr, "/oled/line/2", "ALSA open FAIL");
         sleep(5);
         close(osc_sock); close(mother_sock);
         return 4;
     }
-    osc_send_str(mother_sock, &mother_addr, "/oled/line/2", "ALSA opened");
-
-    snd_pcm_hw_params_t* hw_params;
-    snd_pcm_hw_params_alloca(&hw_params);
-    snd_pcm_hw_params_any(pcm, hw_params);
-    snd_pcm_hw_params_set_access(pcm, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
-    snd_pcm_hw_params_set_format(pcm, hw_params, SND_PCM_FORMAT_S16_LE);
-    snd_pcm_hw_params_set_channels(pcm, hw_params, CHANNELS);
-    unsigned int rate = SAMPLE_RATE;
-    snd_pcm_hw_params_set_rate_near(pcm, hw_params, &rate, nullptr);
-    snd_pcm_uframes_t period = PERIOD_FRAMES;
-    snd_pcm_hw_params_set_period_size_near(pcm, hw_params, &period, nullptr);
-    snd_pcm_uframes_t bufsize = PERIOD_FRAMES * 4;
-    snd_pcm_hw_params_set_buffer_size_near(pcm, hw_params, &bufsize);
-
-    err = snd_pcm_hw_params(pcm, hw_params);
-    if (err < 0) {
-        fprintf(stderr, "ALSA hw_params: %s\n", snd_strerror(err));
+    if (alsaInit.exitCode == 5) {
+        fprintf(stderr, "ALSA hw_params: %s\n", snd_strerror(alsaInit.err));
         osc_send_str(mother_sock, &mother_addr, "/oled/line/2", "hw_params FAIL");
         sleep(5);
-        snd_pcm_close(pcm); close(osc_sock); close(mother_sock);
+        snd_pcm_close(audio.pcm); close(osc_sock); close(mother_sock);
         return 5;
     }
-    snd_pcm_prepare(pcm);
-    osc_send_str(mother_sock, &mother_addr, "/oled/line/2", "Audio ready");
-    osc_send_1i(mother_sock, &mother_addr, "/led", LED_COLORS[0]);
-
-    // ── Voice + params + effects ──
-    Voice voice;
-    TriLFO pwmLfo;
-    NoteTracker tracker;
-    Distortion dist;
-    Reverb reverb;
-    reverb.init();
-    float releaseNorm  = 0.0f;
-    float volTarget    = 0.5f;
-    float volSmooth    = 0.5f;
-    float cutoffTarget = 8000.0f;
-    float cutoffSmooth = 8000.0f;
-    float resoTarget   = 0.0f;
-    float resoSmooth   = 0.0f;
-    int   oledCounter  = OLED_INTERVAL;  // trigger immediate OLED draw
+    snd_pcm_t* pcm = audio.pcm;
+    fprintf(stderr, "ALSA %s: %s %u Hz, period %lu, buffer %lu frames (%.1f ms)%s\n",
+            audio.mmap ? "mmap" : "writei", FORMAT_NAMES[audio.format], audio.rate,
+            (unsigned long)audio.period, (unsigned long)audio.bufsize, audio.latencyMs(),
+            autotune ? ", auto-tuning" : "");
+    // Every rate-dependent coefficient derives from this: set before the Synth
+    set_sample_rate(audio.rate);
+
+    // ── Synth (audio thread state) + control/meter rings ──
+    const uint64_t synthStartNs = now_ns();
+    Synth synth;
+    synth.init(controlInterval, polyMode, fdnReverb);
+    if (fdnReverb) fprintf(stderr, "Reverb: 8-line FDN\n");
+    if (useWavetable) {
+        g_wavetables.init();
+        synth.setWavetables(&g_wavetables);
+        fprintf(stderr, "Oscillator engine: wavetable\n");
+    }
+    if (polyMode) fprintf(stderr, "Voice mode: poly (%d voices)\n", POLY_VOICES);
+    synth.setUnison(unison, detune, spread);
+    if (unison)
+        fprintf(stderr, "Voice mode: mono, unison %d x +/-%.0f cents, spread %.2f\n",
+                unison, detune, spread);
+    synth.setOversample(oversample);
+    if (synth.dist.osFactor > 1)
+        fprintf(stderr, "Distortion: %dx oversampled above amount %.2f\n",
+                synth.dist.osFactor, Distortion::OS_ON);
+    static ParamQueue params;
+    ParamSender paramTx;
+    paramTx.q = &params;
+    static SpscRing<MeterFrame, 64>  meters;
+    static PatchPool patchPool;
+    synth.patches = &patchPool;
+
+    // Last patch, applied before the audio thread starts
+    PresetBank* bank = preset_bank_open(presetPath);
+    Preset live{};   // current control state, what /preset/store saves
+    {
+        ModMatrix defaults;
+        memcpy(live.modSource, defaults.source, sizeof(live.modSource));
+        memcpy(live.modDest,   defaults.dest,   sizeof(live.modDest));
+        memcpy(live.modDepth,  defaults.depth,  sizeof(live.modDepth));
+    }
+    bool bootPreset = bank && bank->last < PRESET_SLOTS && bank->slot[bank->last].used;
+    if (bootPreset) {
+        live = bank->slot[bank->last];
+        SynthPatch patch;
+        decode_preset(live, patch);
+        synth.applyPatch(patch);
+        fprintf(stderr, "Preset %d loaded\n", bank->last);
+    }
+    static LoadHistogram loadHist;
+    static Recorder recorder;
+    recorder.dir = recordDir;
+
+    const uint64_t synthNs = now_ns() - synthStartNs;
+
+    // Audio buffer (writei fallback only; sized for 4-byte samples)
+    static int32_t buf[MAX_PERIOD_FRAMES * CHANNELS];
+    audio.staging = (uint8_t*)buf;
+
+    // ── Real-time audio thread: lock memory, SCHED_FIFO (fall back if not permitted) ──
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0)
+        fprintf(stderr, "mlockall: %s\n", strerror(errno));
+
+    audio.tuning.store(autotune);
+    AudioContext actx{&audio, &synth, &params, &meters, &loadHist, &recorder};
+    pthread_t audio_tid;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 256 * 1024);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+    struct sched_param sp{};
+    sp.sched_priority = AUDIO_RT_PRIORITY;
+    pthread_attr_setschedparam(&attr, &sp);
+    int terr = pthread_create(&audio_tid, &attr, audio_thread, &actx);
+    if (terr != 0) {
+        fprintf(stderr, "SCHED_FIFO audio thread: %s, using default scheduling\n", strerror(terr));
+        pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+        terr = pthread_create(&audio_tid, &attr, audio_thread, &actx);
+    }
+    pthread_attr_destroy(&attr);
+    if (terr != 0) {
+        fprintf(stderr, "audio thread: %s\n", strerror(terr));
+        osc_send_str(mother_sock, &mother_addr, "/oled/line/2", "thread FAIL");
+        sleep(5);
+        snd_pcm_close(pcm); close(osc_sock); close(mother_sock);
+        return 6;
+    }
+    fprintf(stderr, "init: sockets %.1f ms (%d binds) | ALSA open %.1f ms (%d tries), "
+                    "hw_params %.1f ms | synth %.1f ms | audio running at %.1f ms\n",
+            socketsNs * 1e-6, bindAttempts, alsaInit.openNs * 1e-6, alsaInit.attempts,
+            alsaInit.configNs * 1e-6, synthNs * 1e-6, (now_ns() - startNs) * 1e-6);
+
+    // Disk writer for /record: default scheduling, small stack (mlockall
+    // locks every thread stack in full)
+    pthread_t rec_tid;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 64 * 1024);
+    bool recThread = pthread_create(&rec_tid, &attr, recorder_thread, &recorder) == 0;
+    pthread_attr_destroy(&attr);
+    if (!recThread) fprintf(stderr, "recorder thread failed, /record disabled\n");
+
+    // ── Control thread state (OSC, knob decoding, OLED) ──
+    int   waveform     = 0;
     float peakLevel    = 0.0f;
+    float distAmount   = 0.0f;
+    float reverbAmount = 0.0f;
+    uint64_t nextOledNs = now_ns();   // trigger immediate OLED draw
+
+    // Instrumentation: DSP load EMA and per-window worst cases, split into
+    // audio render (DSP), period wall time (kernel/PCM scheduling) and
+    // control-loop work (OSC decode + OLED)
+    uint32_t periodFrames  = (uint32_t)audio.period;   // as last reported by the audio thread
+    float    dspLoad       = 0.0f;        // render / period, smoothed
+    uint32_t winRenderNs   = 0;
+    uint32_t winWallNs     = 0;
+    uint32_t winControlNs  = 0;
+    uint32_t lastXruns     = 0;
+    uint32_t lastRecDrops  = 0;
+    bool     statsRequested = false;
+    uint64_t nextStatsNs   = now_ns() + STATS_INTERVAL_MS * 1000000ull;
+    bool     tuning        = autotune;
+    char     notice[32]    = "";   // temporary OLED line 5 text
+    uint64_t noticeUntilNs = 0;
 
     // Display values for OLED formatting
     float dispPortoMs   = 0.0f;
@@ -722,234 +1343,390 @@ int main() {
     float dispReleaseMs = 200.0f;
     float dispRatio     = 1.0f;
 
-    // Previous OLED strings / VU for dirty checking
-    char prevLine1[32] = "";
-    char prevLine2[32] = "";
-    char prevLine3[32] = "";
-    char prevLine4[32] = "";
-    int  prevVuWidth    = -1;
-    char prevLine5[32] = "";
-
-    voice.filt.setParams(cutoffTarget, resoTarget);
-    voice.porta.setTime(0.0f);
-
-    // Audio buffer
-    int16_t buf[PERIOD_FRAMES * CHANNELS];
-    uint8_t osc_buf[512];
-
-    // ── Main audio loop ──
+    // Display transport: every message the loop sends, pre-encoded once
+    OscMsg ledMsg, statsMsg;
+    static OledView oled;
+    oled.init();
+    ledMsg.init("/led", "i");
+    char statsTypes[7 + LOAD_HIST_BINS + 1];
+    memset(statsTypes, 'i', 7 + LOAD_HIST_BINS);
+    statsTypes[7 + LOAD_HIST_BINS] = 0;
+    statsMsg.init("/stats", statsTypes);
+    OscBatch batch;
+    batch.bundle = oscBundle;
+
+    // Knob pickup after a recall: each knob keeps the preset's value until
+    // it reaches it (within PICKUP_WINDOW) or crosses it, so touching one
+    // knob does not overwrite the other four
+    bool    pickupHeld[5] = {};
+    int     pickupSide[5] = {};
+    int32_t pickupVal[5]  = {};
+
+    // Take over a preset's control state (audio side is applied separately)
+    auto adoptPreset = [&](const Preset& p) {
+        live = p;
+        waveform = p.waveform % NUM_WAVEFORMS;
+        const KnobCurves& c = knob_curves();
+        dispPortoMs   = p.porta * (500.0f / 1023.0f);
+        dispRatio     = c.ratio.at(p.ratio);
+        dispCutoffHz  = c.cutoffHz.at(p.cutoff);
+        dispReso      = p.reso * (0.95f / 1023.0f);
+        dispReleaseMs = c.releaseMs.at(p.release);
+        const int32_t vals[5] = {waveform == 3 ? p.ratio : p.porta,
+                                 p.cutoff, p.reso, p.release, p.volume};
+        for (int k = 0; k < 5; k++) {
+            pickupHeld[k] = true;
+            pickupSide[k] = 0;
+            pickupVal[k]  = vals[k];
+        }
+        ledMsg.setInt(0, LED_COLORS[waveform]);
+        batch.add(ledMsg);
+    };
+    if (bootPreset) adoptPreset(live);
+    // Ready only once the boot preset is in both the synth and the control
+    // state, so the first notes already sound (and show) the patch
+    osc_send_str(mother_sock, &mother_addr, "/oled/line/2", "Audio ready");
+    osc_send_1i(mother_sock, &mother_addr, "/led", LED_COLORS[waveform]);
+
+    static OscRx rx;
+    OscDispatch dispatch;
+    dispatch.add("/key",   OSC_KEY);
+    dispatch.add("/knobs", OSC_KNOBS);
+    dispatch.add("/aux",   OSC_AUX);
+    dispatch.add("/stats", OSC_STATS);
+    dispatch.add("/record", OSC_RECORD);
+    dispatch.add("/mod",    OSC_MOD);
+    dispatch.add("/preset/recall", OSC_PRESET_RECALL);
+    dispatch.add("/preset/store",  OSC_PRESET_STORE);
+    dispatch.add("/quit",  OSC_QUIT);
+    uint32_t knobsCoalesced = 0;
+    // Latest undecoded /knobs; survives a loop iteration when the ring is full
+    bool     knobsPending = false;
+    int32_t  knobVals[5];
+    uint64_t knobsT = 0;
+
+    // ── Control loop: block on OSC until the next OLED frame is due ──
     while (g_running) {
-        // Poll OSC messages (non-blocking)
+        uint64_t now = now_ns();
+        int timeoutMs = (now >= nextOledNs) ? 0 : (int)((nextOledNs - now) / 1000000ull);
+        struct pollfd pfd = {osc_sock, POLLIN, 0};
+        poll(&pfd, 1, timeoutMs);
+        uint64_t workStartNs = now_ns();
+
+        // REALTIME → MONOTONIC offset for the kernel arrival stamps
+        struct timespec rts;
+        clock_gettime(CLOCK_REALTIME, &rts);
+        int64_t realToMonoNs = ((int64_t)rts.tv_sec * 1000000000ll + rts.tv_nsec)
+                             - (int64_t)now_ns();
+
+        // Drain OSC in recvmmsg batches. Consecutive /knobs messages are
+        // coalesced: only the latest is decoded, when anything else arrives
+        // or the socket is empty, so sweeps skip the decode work for
+        // positions nobody hears. A decode the ring has no room for stays
+        // pending (pickup untouched) and is retried with the next flush
+        auto flushKnobs = [&]() {
+            if (!knobsPending || !paramTx.knobRoom()) return;
+            for (int k = 0; k < 5; k++) {
+                if (!pickupHeld[k]) continue;
+                int d = knobVals[k] - pickupVal[k];
+                int side = d > 0 ? 1 : -1;
+                if (abs(d) <= PICKUP_WINDOW || (pickupSide[k] != 0 && side != pickupSide[k])) {
+                    pickupHeld[k] = false;
+                } else {
+                    pickupSide[k] = side;
+                    knobVals[k]   = pickupVal[k];
+                }
+            }
+            if (waveform == 3) live.ratio = (uint16_t)knobVals[0];
+            else               live.porta = (uint16_t)knobVals[0];
+            live.cutoff  = (uint16_t)knobVals[1];
+            live.reso    = (uint16_t)knobVals[2];
+            live.release = (uint16_t)knobVals[3];
+            live.volume  = (uint16_t)knobVals[4];
+            knobs_to_events(params, knobsT, waveform,
+                            knobVals[0], knobVals[1], knobVals[2], knobVals[3], knobVals[4],
+                            dispPortoMs, dispRatio, dispCutoffHz,
+                            dispReso, dispReleaseMs);
+            knobsPending = false;
+            // OLED updates on regular 50ms cycle (no forced redraw)
+        };
         for (;;) {
-            ssize_t n = recv(osc_sock, osc_buf, sizeof(osc_buf), 0);
-            if (n <= 0) break;
-
-            // Parse OSC address
-            const char* addr = (const char*)osc_buf;
-            int addr_len = osc_pad((int)strnlen(addr, n) + 1);
-            if (addr_len >= n) continue;
-
-            // Compute args offset from actual type tag length
-            const char* typetag = (const char*)(osc_buf + addr_len);
-            int args_off = addr_len + osc_pad((int)strnlen(typetag, n - addr_len) + 1);
-
-            if (strcmp(addr, "/key") == 0 && n >= args_off + 8) {
-                // /key <index:i> <vel:i>
-                int32_t index = osc_int(osc_buf + args_off);
-                int32_t vel   = osc_int(osc_buf + args_off + 4);
-                if (index > 0 && index < 25) {  // keys 1-24
-                    int note = index + 59;
-                    if (vel > 0) {
-                        voice.noteOn(note);
-                        tracker.noteOn();
+            PROBE(PROBE_OSC_IN);
+            int nrx = rx.receive(osc_sock, realToMonoNs);
+            for (int r = 0; r < nrx; r++) {
+                const uint8_t* osc_buf = rx.buf[r];
+                int      n = rx.len[r];
+                uint64_t t = rx.timeNs[r];
+
+                // Parse OSC address
+                const char* addr = (const char*)osc_buf;
+                int addr_len = osc_pad((int)strnlen(addr, n) + 1);
+                if (addr_len >= n) continue;
+
+                // Compute args offset from actual type tag length
+                const char* typetag = (const char*)(osc_buf + addr_len);
+                int args_off = addr_len + osc_pad((int)strnlen(typetag, n - addr_len) + 1);
+
+                OscAddr id = dispatch.find(addr);
+                if (id == OSC_KNOBS) {
+                    // /knobs <k1> <k2> <k3> <k4> <k5> (K6 ignored if present)
+                    if (n < args_off + 20) continue;
+                    if (knobsPending) knobsCoalesced++;
+                    for (int k = 0; k < 5; k++) knobVals[k] = osc_int(osc_buf + args_off + 4 * k);
+                    knobsT = t;
+                    knobsPending = true;
+                    continue;
+                }
+                flushKnobs();   // keep event order (and the waveform K1 decodes with)
+
+                switch (id) {
+                case OSC_KEY:
+                    // /key <index:i> <vel:i>
+                    if (n >= args_off + 8) {
+                        int32_t index = osc_int(osc_buf + args_off);
+                        int32_t vel   = osc_int(osc_buf + args_off + 4);
+                        if (index > 0 && index < 25) {  // keys 1-24
+                            int note = index + 59;
+                            paramTx.send({vel > 0 ? ParamEvent::NOTE_ON : ParamEvent::NOTE_OFF,
+                                          note, 0.0f, 0.0f, t});
+                        } else if (index == 0 && vel > 0) {  // AUX button
+                            waveform = (waveform + 1) % NUM_WAVEFORMS;
+                            paramTx.send({ParamEvent::WAVEFORM, waveform, 0.0f, 0.0f, t});
+                            live.waveform = (uint8_t)waveform;
+                            pickupHeld[0] = false;   // K1 now means the other parameter
+                            ledMsg.setInt(0, LED_COLORS[waveform]);
+                            ledMsg.send(mother_sock, &mother_addr);
+                        }
+                    }
+                    break;
+                case OSC_AUX:
+                    if (n >= args_off + 4 && osc_int(osc_buf + args_off) > 0) {
+                        waveform = (waveform + 1) % NUM_WAVEFORMS;
+                        paramTx.send({ParamEvent::WAVEFORM, waveform, 0.0f, 0.0f, t});
+                        live.waveform = (uint8_t)waveform;
+                        pickupHeld[0] = false;
+                        ledMsg.setInt(0, LED_COLORS[waveform]);
+                        ledMsg.send(mother_sock, &mother_addr);
+                    }
+                    break;
+                case OSC_STATS:
+                    statsRequested = true;   // reply now instead of at the next interval
+                    break;
+                case OSC_RECORD:
+                    // /record <on:i>; the writer thread opens / finalises the file
+                    if (n >= args_off + 4 && recThread)
+                        recorder.request.store(osc_int(osc_buf + args_off) > 0,
+                                               std::memory_order_release);
+                    break;
+                case OSC_MOD:
+                    // /mod <slot> <source> <dest> <depth> (each i or f);
+                    // applied on the audio thread at the next block
+                    if (n >= args_off + 16 && strnlen(typetag, n - addr_len) >= 5) {
+                        float v[4];
+                        for (int k = 0; k < 4; k++)
+                            v[k] = osc_num(osc_buf + args_off + 4 * k, typetag[1 + k]);
+                        int route = ((int)v[0] & 0xff) | ((int)v[1] & 0xff) << 8
+                                  | ((int)v[2] & 0xff) << 16;
+                        paramTx.send({ParamEvent::MOD_ROUTE, route, v[3], 0.0f, t});
+                        int slot = (int)v[0], src = (int)v[1], dst = (int)v[2];
+                        if (slot >= 0 && slot < MOD_SLOTS && src >= 0 && src < MOD_SOURCES
+                            && dst >= 0 && dst < MOD_DESTS) {
+                            live.modSource[slot] = (uint8_t)src;
+                            live.modDest[slot]   = (uint8_t)dst;
+                            live.modDepth[slot]  = v[3];
+                        }
+                    }
+                    break;
+                case OSC_PRESET_RECALL:
+                case OSC_PRESET_STORE: {
+                    // /preset/recall <n>, /preset/store <n> (i or f)
+                    if (n < args_off + 4 || !bank) break;
+                    int slot = (int)osc_num(osc_buf + args_off, typetag[1]);
+                    if (slot < 0 || slot >= PRESET_SLOTS) break;
+                    if (id == OSC_PRESET_STORE) {
+                        live.used = 1;
+                        bank->slot[slot] = live;
+                        bank->last = (uint8_t)slot;
+                        msync(bank, sizeof(PresetBank), MS_ASYNC);
+                        snprintf(notice, sizeof(notice), "Stored %d", slot);
                     } else {
-                        tracker.noteOff();
-                        voice.noteOff(note);
+                        SynthPatch* sp = patchPool.next();
+                        if (!bank->slot[slot].used) {
+                            snprintf(notice, sizeof(notice), "Preset %d empty", slot);
+                        } else if (!sp) {
+                            snprintf(notice, sizeof(notice), "Preset busy");
+                        } else {
+                            Preset p = bank->slot[slot];
+                            decode_preset(p, *sp);
+                            uint32_t i = patchPool.issued.load(std::memory_order_relaxed);
+                            if (paramTx.trySend({ParamEvent::PATCH, (int32_t)(i % PatchPool::SIZE),
+                                                 0.0f, 0.0f, t})) {
+                                patchPool.issued.store(i + 1, std::memory_order_release);
+                                adoptPreset(p);
+                                bank->last = (uint8_t)slot;
+                                snprintf(notice, sizeof(notice), "Preset %d", slot);
+                            } else {
+                                snprintf(notice, sizeof(notice), "Preset busy");
+                            }
+                        }
                     }
-                } else if (index == 0 && vel > 0) {  // AUX button
-                    voice.targetWaveform = (voice.targetWaveform + 1) % NUM_WAVEFORMS;
-                    osc_send_1i(mother_sock, &mother_addr, "/led",
-                                LED_COLORS[voice.targetWaveform]);
-                }
-            }
-            else if (strcmp(addr, "/knobs") == 0 && n >= args_off + 20) {
-                // /knobs <k1> <k2> <k3> <k4> <k5> (K6 ignored if present)
-                int32_t k1 = osc_int(osc_buf + args_off);
-                int32_t k2 = osc_int(osc_buf + args_off + 4);
-                int32_t k3 = osc_int(osc_buf + args_off + 8);
-                int32_t k4 = osc_int(osc_buf + args_off + 12);
-                int32_t k5 = osc_int(osc_buf + args_off + 16);
-
-                // K1: depends on waveform mode
-                if (voice.targetWaveform == 3) {
-                    // Ratio PWM mode: K1 controls PWM ratio 0.0625–8.0 continuous
-                    voice.osc.pwmRatio = 0.0625f * powf(128.0f, k1 / 1023.0f);
-                    dispRatio = voice.osc.pwmRatio;
-                } else {
-                    // Portamento 0–500ms linear (also sets PWM LFO rate)
-                    float portoMs = k1 * (500.0f / 1023.0f);
-                    voice.porta.setTime(portoMs);
-                    pwmLfo.setPeriodMs(portoMs);
-                    dispPortoMs = portoMs;
+                    noticeUntilNs = now_ns() + NOTICE_SHOW_MS * 1000000ull;
+                    break;
                 }
-
-                // K2: Filter cutoff 20–18kHz exponential (target only, smoothed in audio loop)
-                cutoffTarget = 20.0f * powf(900.0f, k2 / 1023.0f);
-                dispCutoffHz = cutoffTarget;
-
-                // K3: Filter resonance 0–0.95 (target only)
-                resoTarget = k3 * (0.95f / 1023.0f);
-                dispReso = resoTarget;
-
-                // K4: Amp release 10–2000ms exponential
-                float releaseMs = 10.0f * powf(200.0f, k4 / 1023.0f);
-                voice.env.setRelease(releaseMs);
-                dispReleaseMs = releaseMs;
-                releaseNorm = k4 / 1023.0f;
-
-                // K5: Master volume 0–1
-                volTarget = k5 / 1023.0f;
-
-                // OLED updates on regular 50ms cycle (no forced redraw)
-            }
-            else if (strcmp(addr, "/aux") == 0 && n >= args_off + 4) {
-                int32_t auxVal = osc_int(osc_buf + args_off);
-                if (auxVal > 0) {
-                    voice.targetWaveform = (voice.targetWaveform + 1) % NUM_WAVEFORMS;
-                    osc_send_1i(mother_sock, &mother_addr, "/led",
-                                LED_COLORS[voice.targetWaveform]);
+                case OSC_QUIT:
+                    g_running = 0;
+                    break;
+                default:
+                    break;
                 }
             }
-            else if (strcmp(addr, "/quit") == 0) {
-                g_running = 0;
+            if (nrx < OSC_RX_BATCH) break;
+        }
+        paramTx.retry();   // a backlog left by a full ring goes out ahead of the knobs
+        flushKnobs();
+
+        // Collect meter data from the audio thread
+        MeterFrame mf;
+        while (meters.pop(mf)) {
+            if (mf.peak > peakLevel) peakLevel = mf.peak;
+            distAmount   = mf.distAmount;
+            reverbAmount = mf.reverbAmount;
+            if (mf.frames != periodFrames) {
+                fprintf(stderr, "auto-tune: period %u -> %u frames\n", periodFrames, mf.frames);
+                periodFrames = mf.frames;
             }
+            dspLoad += LOAD_SMOOTH_COEFF * (mf.renderNs * 1e-9f * g_sampleRate / mf.frames - dspLoad);
+            if (mf.renderNs > winRenderNs) winRenderNs = mf.renderNs;
+            if (mf.wallNs > winWallNs) winWallNs = mf.wallNs;
         }
 
-        // Fill audio buffer
-        for (int i = 0; i < PERIOD_FRAMES; i++) {
-            // Smooth control parameters (one-pole)
-            cutoffSmooth += PARAM_SMOOTH_COEFF * (cutoffTarget - cutoffSmooth);
-            resoSmooth   += PARAM_SMOOTH_COEFF * (resoTarget - resoSmooth);
-            volSmooth    += PARAM_SMOOTH_COEFF * (volTarget - volSmooth);
+        uint32_t xruns = audio.xruns.load(std::memory_order_relaxed);
+        if (xruns != lastXruns) {
+            fprintf(stderr, "xrun #%u: dsp %.0f%% (worst %uus), period wall %uus, control %uus\n",
+                    xruns, dspLoad * 100.0f, winRenderNs / 1000, winWallNs / 1000,
+                    winControlNs / 1000);
+            lastXruns = xruns;
+        }
+        uint32_t recDrops = recorder.overflows.load(std::memory_order_relaxed);
+        if (recDrops != lastRecDrops) {
+            fprintf(stderr, "record: ring full, %u chunks dropped so far\n", recDrops);
+            lastRecDrops = recDrops;
+        }
 
-            if (voice.targetWaveform != 3) {
-                voice.osc.pulseWidth = 0.5f + 0.4f * pwmLfo.tick();
-            } else {
-                pwmLfo.tick();  // keep phase advancing to avoid discontinuity on mode switch
-            }
-            voice.filt.setParams(cutoffSmooth, resoSmooth);
-
-            // Update dynamics
-            tracker.tick();
-            dist.updateFromDynamics(tracker.speed, releaseNorm);
-            reverb.updateFromDynamics(tracker.length, releaseNorm);
-
-            // Signal chain: osc → filter → envelope → distortion → reverb
-            float s = voice.tick();
-            s = dist.process(s);
-            float outL, outR;
-            reverb.process(s, outL, outR);
-            outL *= volSmooth;
-            outR *= volSmooth;
-
-            // Soft clip
-            if (outL > 1.0f) outL = 1.0f;
-            else if (outL < -1.0f) outL = -1.0f;
-            if (outR > 1.0f) outR = 1.0f;
-            else if (outR < -1.0f) outR = -1.0f;
-
-            // Track peak level for VU (use louder channel)
-            float absL = fabsf(outL), absR = fabsf(outR);
-            float absS = absL > absR ? absL : absR;
-            if (absS > peakLevel) peakLevel = absS;
-
-            buf[i * 2]     = (int16_t)(outL * 32767.0f * MASTER_GAIN);  // L
-            buf[i * 2 + 1] = (int16_t)(outR * 32767.0f * MASTER_GAIN);  // R
+        if (tuning && !audio.tuning.load(std::memory_order_acquire)) {
+            tuning = false;
+            fprintf(stderr, "auto-tune: settled at period %lu, buffer %lu frames, %.1f ms\n",
+                    (unsigned long)audio.period, (unsigned long)audio.bufsize, audio.latencyMs());
+            snprintf(notice, sizeof(notice), "Lat:%.1fms P:%lu", audio.latencyMs(),
+                     (unsigned long)audio.period);
+            noticeUntilNs = now_ns() + LATENCY_SHOW_MS * 1000000ull;
         }
 
-        // Write to ALSA
-        snd_pcm_sframes_t frames = snd_pcm_writei(pcm, buf, PERIOD_FRAMES);
-        if (frames < 0) {
-            // EPIPE = underrun; try to recover
-            frames = snd_pcm_recover(pcm, (int)frames, 0);
-            if (frames < 0) {
-                fprintf(stderr, "ALSA write error: %s\n", snd_strerror((int)frames));
-                osc_send_str(mother_sock, &mother_addr, "/oled/line/2", "ALSA write ERR");
-                sleep(3);
-                break;
-            }
+        // ── /stats (every STATS_INTERVAL_MS, or on request) ──
+        // load‰, worst render µs, worst period wall µs, worst control µs,
+        // xruns, param-ring deferrals and drops, then the cumulative
+        // render-time histogram bins
+        if (statsRequested || now_ns() >= nextStatsNs) {
+            statsMsg.setInt(0, (int32_t)(dspLoad * 1000.0f));
+            statsMsg.setInt(1, (int32_t)(winRenderNs / 1000));
+            statsMsg.setInt(2, (int32_t)(winWallNs / 1000));
+            statsMsg.setInt(3, (int32_t)(winControlNs / 1000));
+            statsMsg.setInt(4, (int32_t)xruns);
+            statsMsg.setInt(5, (int32_t)paramTx.deferred);
+            statsMsg.setInt(6, (int32_t)paramTx.dropped);
+            for (int b = 0; b < LOAD_HIST_BINS; b++)
+                statsMsg.setInt(7 + b, (int32_t)loadHist.bins[b].load(std::memory_order_relaxed));
+            batch.add(statsMsg);
+            winRenderNs = winWallNs = winControlNs = 0;
+            statsRequested = false;
+            nextStatsNs = now_ns() + STATS_INTERVAL_MS * 1000000ull;
         }
 
-        // ── OLED update (every ~50ms) ──
-        oledCounter += PERIOD_FRAMES;
-        if (oledCounter >= OLED_INTERVAL) {
-            oledCounter -= OLED_INTERVAL;
+        int aerr = g_audioError.load();
+        if (aerr < 0) {
+            fprintf(stderr, "ALSA write error: %s\n", snd_strerror(aerr));
+            osc_send_str(mother_sock, &mother_addr, "/oled/line/2", "ALSA write ERR");
+            sleep(3);
+            break;
+        }
 
-            char line[32];
+        // ── OLED update (every ~50ms) ──
+        now = now_ns();
+        if (now >= nextOledNs) {
+            PROBE(PROBE_OLED);
+            nextOledNs = now + OLED_INTERVAL_MS * 1000000ull;
 
             // Line 1: Portamento or Ratio (depends on waveform mode)
-            if (voice.targetWaveform == 3) {
-                snprintf(line, sizeof(line), "Ratio: %.2fx", dispRatio);
-            } else {
-                snprintf(line, sizeof(line), "Porto: %dms", (int)dispPortoMs);
-            }
-            if (strcmp(line, prevLine1) != 0) {
-                osc_send_str(mother_sock, &mother_addr, "/oled/line/1", line);
-                strcpy(prevLine1, line);
-            }
+            if (waveform == 3)
+                oled.row(0, 1, oled_bits(dispRatio), 0, "Ratio: %.2fx", dispRatio);
+            else
+                oled.row(0, 0, (uint32_t)dispPortoMs, 0, "Porto: %dms", (int)dispPortoMs);
 
             // Line 2: Cutoff (Hz or kHz)
             if (dispCutoffHz >= 1000.0f)
-                snprintf(line, sizeof(line), "Cutoff: %.1fkHz", dispCutoffHz / 1000.0f);
+                oled.row(1, 1, oled_bits(dispCutoffHz), 0, "Cutoff: %.1fkHz", dispCutoffHz / 1000.0f);
             else
-                snprintf(line, sizeof(line), "Cutoff: %dHz", (int)dispCutoffHz);
-            if (strcmp(line, prevLine2) != 0) {
-                osc_send_str(mother_sock, &mother_addr, "/oled/line/2", line);
-                strcpy(prevLine2, line);
-            }
+                oled.row(1, 0, (uint32_t)dispCutoffHz, 0, "Cutoff: %dHz", (int)dispCutoffHz);
 
             // Line 3: Resonance
-            snprintf(line, sizeof(line), "Reso: %.2f", dispReso);
-            if (strcmp(line, prevLine3) != 0) {
-                osc_send_str(mother_sock, &mother_addr, "/oled/line/3", line);
-                strcpy(prevLine3, line);
-            }
+            oled.row(2, 0, oled_bits(dispReso), 0, "Reso: %.2f", dispReso);
 
             // Line 4: Release
             if (dispReleaseMs >= 1000.0f)
-                snprintf(line, sizeof(line), "Release: %.1fs", dispReleaseMs / 1000.0f);
+                oled.row(3, 1, oled_bits(dispReleaseMs), 0, "Release: %.1fs", dispReleaseMs / 1000.0f);
             else
-                snprintf(line, sizeof(line), "Release: %dms", (int)dispReleaseMs);
-            if (strcmp(line, prevLine4) != 0) {
-                osc_send_str(mother_sock, &mother_addr, "/oled/line/4", line);
-                strcpy(prevLine4, line);
+                oled.row(3, 0, (uint32_t)dispReleaseMs, 0, "Release: %dms", (int)dispReleaseMs);
+
+            // Line 5: Distortion + Reverb amounts, or DSP load / xruns;
+            // auto-tune progress and its result take it over for a while
+            if (tuning) {
+                oled.row(4, 0, periodFrames, 0, "Tuning: %u frames", periodFrames);
+            } else if (now < noticeUntilNs) {
+                oled.row(4, 1, oled_hash(notice), 0, "%s", notice);
+            } else if (statsOled) {
+                int loadPct = (int)(dspLoad * 100.0f);
+                oled.row(4, 2, (uint32_t)loadPct, xruns, "DSP:%d%% X:%u", loadPct, xruns);
+            } else {
+                int dstPct = (int)(distAmount * 100.0f);
+                int rvbPct = (int)(reverbAmount * 100.0f);
+                oled.row(4, 3, (uint32_t)dstPct, (uint32_t)rvbPct, "Dst:%d%% Rvb:%d%%", dstPct, rvbPct);
             }
 
-            // Line 5: Distortion + Reverb amounts
-            int dstPct = (int)(dist.amount * 100.0f);
-            int rvbPct = (int)(reverb.amount * 100.0f);
-            snprintf(line, sizeof(line), "Dst:%d%% Rvb:%d%%", dstPct, rvbPct);
-            if (strcmp(line, prevLine5) != 0) {
-                osc_send_str(mother_sock, &mother_addr, "/oled/line/5", line);
-                strcpy(prevLine5, line);
-            }
+            // VU bar at the bottom of the screen, then peak decay
+            oled.vu(peakLevel);
+            peakLevel *= 0.95f;
 
-            // VU bar: graphical filled rectangle at bottom of OLED (128x64)
-            int vuWidth = (int)(peakLevel * 122.0f);
-            if (vuWidth > 122) vuWidth = 122;
-            if (vuWidth != prevVuWidth) {
-                osc_send_5i(mother_sock, &mother_addr, "/oled/gBox", 3, 55, 125, 62, 0);
-                if (vuWidth > 0)
-                    osc_send_5i(mother_sock, &mother_addr, "/oled/gBox", 3, 55, 3 + vuWidth, 62, 1);
-                prevVuWidth = vuWidth;
-            }
+            oled.flush(batch);
+        }
 
-            // Peak decay
-            peakLevel *= 0.95f;
+        batch.flush(mother_sock, &mother_addr);   // this iteration's display + /stats
+
+        uint32_t workNs = (uint32_t)(now_ns() - workStartNs);
+        if (workNs > winControlNs) winControlNs = workNs;
+
+#if MONOSYNTH_PROBES
+        if (g_probeDump) {
+            g_probeDump = 0;
+            probe_dump(stderr);
         }
+#endif
     }
 
+    fprintf(stderr, "stats: %u xruns, worst render %uus of %dus, %u /knobs coalesced, "
+            "%u events deferred / %u dropped on a full ring, %u OLED frames over budget\n",
+            audio.xruns.load(), loadHist.worstNs.load() / 1000,
+            (int)(1e6f * periodFrames * g_invSR), knobsCoalesced,
+            paramTx.deferred, paramTx.dropped, oled.deferred);
+    probe_dump(stderr);
+
     // Cleanup
+    g_running = 0;
+    pthread_join(audio_tid, nullptr);
+    if (bank) {
+        msync(bank, sizeof(PresetBank), MS_SYNC);
+        munmap(bank, sizeof(PresetBank));
+    }
+    if (recThread) pthread_join(rec_tid, nullptr);   // finalises an open take
     snd_pcm_drain(pcm);
     snd_pcm_close(pcm);
     close(osc_sock);
@@ -1,55 +1,91 @@
 #!/bin/sh
 # CppMonoSynth launcher for Organelle
 USB_LOG=/usbdrive/Patches/CppMonoSynth/crash.log
+# Extra monosynth options, e.g. "--poly --wavetable --stats-oled" or
+# "--period 64" / "--autotune"; arguments given to run.sh are appended
+MONOSYNTH_ARGS=""
+# Per-rig options file (one option per line, no dashes: "period 64")
+CONF=/tmp/patch/monosynth.conf
+[ -f "$CONF" ] && MONOSYNTH_ARGS="--config $CONF $MONOSYNTH_ARGS"
+# 1 = launch first, collect diagnostics only after a failure;
+# 0 = also check libs and dump diagnostics before every launch
+FAST_START=1
+# Launch phase timings (seconds since this script started)
+BOOT_LOG=/tmp/monosynth_boot.log
+
+T0=$(cut -d' ' -f1 /proc/uptime)
+phase() {
+    awk -v t0="$T0" -v m="$1" '{ printf "t+%.2fs %s\n", $1 - t0, m }' /proc/uptime >> "$BOOT_LOG"
+}
+: > "$BOOT_LOG"
+
+diagnostics() {
+  {
+    echo "=== date ===" ; date
+    echo "=== uname ===" ; uname -a
+    echo "=== ldd ===" ; ldd /tmp/patch/monosynth 2>&1
+    echo "=== file ===" ; file /tmp/patch/monosynth
+    echo "=== ls -la ===" ; ls -la /tmp/patch/monosynth
+    echo "=== aplay -l ===" ; aplay -l 2>&1
+    echo "=== port check ===" ; ss -tulpn 2>/dev/null || netstat -tulpn 2>/dev/null
+    echo "=== proc check ===" ; ps aux 2>/dev/null | grep -i 'jack\|mono\|mother' || true
+  } > /tmp/monosynth_diag.log 2>&1
+}
 
 oscsend localhost 4001 /oled/line/1 s "CppMonoSynth"
 oscsend localhost 4001 /oled/line/2 s "Starting..."
 
-# Kill JACK — we use ALSA directly
+# Kill JACK — we use ALSA directly. Wait for it to actually exit (up to
+# 3 s) instead of a fixed sleep; monosynth itself polls until the PCM
+# device is free
 killall -9 jackd 2>/dev/null
-sleep 3
-oscsend localhost 4001 /oled/line/2 s "JACK killed"
+i=0
+while pidof jackd >/dev/null 2>&1 && [ $i -lt 60 ]; do
+    sleep 0.05
+    i=$((i + 1))
+done
+phase "jackd gone"
 
 # Ensure execute permission (FAT32 USB strips +x)
 chmod +x /tmp/patch/monosynth
 
-oscsend localhost 4001 /oled/line/2 s "Launching..."
-
-# Check for missing shared libs before exec
-if ! ldd /tmp/patch/monosynth >/dev/null 2>/tmp/monosynth_ldd.log; then
-    oscsend localhost 4001 /oled/line/2 s "Lib missing!"
-    oscsend localhost 4001 /oled/line/3 s "See ldd log"
-    cat /tmp/monosynth_ldd.log >> /tmp/monosynth_diag.log 2>&1
-    sleep 10
+if [ "$FAST_START" -eq 0 ]; then
+    # Check for missing shared libs before exec
+    if ! ldd /tmp/patch/monosynth >/dev/null 2>/tmp/monosynth_ldd.log; then
+        oscsend localhost 4001 /oled/line/2 s "Lib missing!"
+        oscsend localhost 4001 /oled/line/3 s "See ldd log"
+        cat /tmp/monosynth_ldd.log >> /tmp/monosynth_diag.log 2>&1
+        sleep 10
+    fi
+    diagnostics
+    phase "diagnostics done"
 fi
 
-# Diagnostics dump
-{
-  echo "=== date ===" ; date
-  echo "=== uname ===" ; uname -a
-  echo "=== ldd ===" ; ldd /tmp/patch/monosynth 2>&1
-  echo "=== file ===" ; file /tmp/patch/monosynth
-  echo "=== ls -la ===" ; ls -la /tmp/patch/monosynth
-  echo "=== aplay -l ===" ; aplay -l 2>&1
-  echo "=== port check ===" ; ss -tulpn 2>/dev/null || netstat -tulpn 2>/dev/null
-  echo "=== proc check ===" ; ps aux 2>/dev/null | grep -i 'jack\|mono\|mother' || true
-} > /tmp/monosynth_diag.log 2>&1
+oscsend localhost 4001 /oled/line/2 s "Launching..."
 
 # Forward SIGTERM to child so Organelle can stop the patch
 trap 'kill -TERM $CHILD 2>/dev/null' TERM INT
 
-# Run binary (not exec) so we can capture exit code for OLED diagnostics
-/tmp/patch/monosynth 2>/tmp/monosynth.log &
+# Run binary (not exec) so we can capture exit code for OLED diagnostics.
+# Its own init timings ("init: ...") go to monosynth.log.
+phase "launch"
+/tmp/patch/monosynth $MONOSYNTH_ARGS "$@" 2>/tmp/monosynth.log &
 CHILD=$!
 wait $CHILD
 EXIT_CODE=$?
+phase "exit $EXIT_CODE"
 
-# Exit code key: 0=clean, 2=socket, 3=bind, 4=ALSA open, 5=hw_params
+# Exit code key: 0=clean, 2=socket, 3=bind, 4=ALSA open, 5=hw_params, 6=audio thread, 7=bad args
 # If still 1, crash happened before our code (dynamic linker, segfault, etc.)
 if [ "$EXIT_CODE" -ne 0 ]; then
     oscsend localhost 4001 /oled/line/2 s "Exit code: $EXIT_CODE"
     oscsend localhost 4001 /oled/line/3 s "Logs on USB"
 
+    if [ "$FAST_START" -ne 0 ]; then
+        ldd /tmp/patch/monosynth >/dev/null 2>/tmp/monosynth_ldd.log
+        diagnostics
+    fi
+
     # Collect all logs and write to USB so Mac can read them
     {
       echo "========================================"
@@ -60,6 +96,9 @@ if [ "$EXIT_CODE" -ne 0 ]; then
       echo "=== stderr (monosynth.log) ==="
       cat /tmp/monosynth.log 2>/dev/null
       echo ""
+      echo "=== launch phases ==="
+      cat "$BOOT_LOG" 2>/dev/null
+      echo ""
       echo "=== diagnostics ==="
       cat /tmp/monosynth_diag.log 2>/dev/null
       echo ""
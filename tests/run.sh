@@ -0,0 +1,76 @@
+#!/bin/sh
+# Golden-render regression test (make test). Each case renders a script
+# (tests/phrase.txt, or tests/drive.txt for the high-drive case) for 1 s in
+# one engine configuration and compares the 16-bit output with
+# tests/golden/<case>.wav, once per build:
+#   bench          default (SIMD paths, libm)
+#   bench-scalar   SIMD=0
+#   bench-lite     PROFILE=lite (fastmath.h approximations)
+# A case fails below its SNR floor (dB) or above its worst-sample error (LSB)
+# for that build. A last check renders tests/recall.txt against
+# tests/recall_ref.txt, which must match exactly. The goldens are default-build renders on x86; the default
+# and scalar floors leave room for another libm or FPU, not for a change in
+# the DSP. After an intended change to the sound, `make golden`
+# (tests/run.sh --update) re-renders them.
+set -u
+cd "$(dirname "$0")/.."
+
+# case         script   bench flags ('_' = space)    default    scalar     lite
+#                                                    dB   LSB   dB   LSB   dB   LSB
+CASES='
+mono           phrase   -                            90   4     90   4     70   48
+poly           phrase   --poly                       90   4     90   4     70   48
+unison         phrase   --unison_4                   90   4     90   4     65   80
+unison_drive   drive    --unison_4                   90   4     90   4     65   80
+fdn            phrase   --fdn-reverb                 90   4     90   4     70   48
+wavetable      phrase   --wavetable                  90   4     90   4     70   48
+poly_wavetable phrase   --poly_--wavetable           90   4     90   4     70   48
+oversample     phrase   --oversample_4               90   4     90   4     70   48
+ctl128         phrase   --control-interval_128       90   4     90   4     70   48
+'
+
+update=0
+[ "${1:-}" = "--update" ] && update=1
+
+fail=0
+while read -r name script flags dSnr dLsb sSnr sLsb lSnr lLsb; do
+    [ -n "$name" ] || continue
+    [ "$flags" = "-" ] && flags=""
+    flags=$(echo "$flags" | tr _ ' ')
+    golden="tests/golden/$name.wav"
+    RENDER="--script tests/$script.txt --seconds 1"
+    if [ $update -eq 1 ]; then
+        ./bench $RENDER $flags --wav "$golden" > /dev/null || exit 1
+        echo "wrote $golden"
+        continue
+    fi
+    for build in "bench $dSnr $dLsb" "bench-scalar $sSnr $sLsb" "bench-lite $lSnr $lLsb"; do
+        set -- $build
+        result=$(./$1 $RENDER $flags --compare "$golden" --min-snr "$2" --max-error "$3" \
+                 | grep '^compare' | sed 's/^[^:]*: //')
+        case "$result" in *pass) ;; *) fail=$((fail + 1)) ;; esac
+        printf '%-14s %-13s %-44s (floor %s dB, %s LSB)\n' "$name" "$1" "${result:-no output}" "$2" "$3"
+    done
+done <<EOF
+$CASES
+EOF
+
+[ $update -eq 1 ] && exit 0
+
+# Preset recall: bad mod entries in a recalled bank slot must render
+# exactly like the same slots at depth 0, in every build (no golden)
+ref=$(mktemp) || exit 1
+for build in bench bench-scalar bench-lite; do
+    ./$build --script tests/recall_ref.txt --seconds 1 --wav "$ref" > /dev/null || fail=$((fail + 1))
+    result=$(./$build --script tests/recall.txt --seconds 1 --compare "$ref" --max-error 0 \
+             | grep '^compare' | sed 's/^[^:]*: //')
+    case "$result" in *pass) ;; *) fail=$((fail + 1)) ;; esac
+    printf '%-14s %-13s %-44s (vs recall_ref, exact)\n' recall "$build" "${result:-no output}"
+done
+rm -f "$ref"
+
+if [ $fail -ne 0 ]; then
+    echo "$fail golden comparison(s) failed"
+    exit 1
+fi
+echo "all golden comparisons passed"